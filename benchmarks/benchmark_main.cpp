@@ -1,9 +1,19 @@
 #include <holohash/benchmark.hpp>
+#include <cstring>
+#include <fstream>
 #include <random>
 
 using namespace holohash;
 using namespace holohash::benchmark;
 
+// Every result of this run, for --json and --baseline
+std::vector<BenchmarkResult> results;
+
+void report(const BenchmarkResult& result) {
+    print_result(result);
+    results.push_back(result);
+}
+
 std::vector<uint8_t> generate_random_data(size_t size) {
     std::random_device rd;
     std::mt19937 gen(rd());
@@ -36,11 +46,127 @@ void run_hash_benchmarks() {
             1000,
             size,
             [&]() {
-                HolographicHash::compute(data, params);
+                return HolographicHash::compute(data, params);
             }
         );
         
-        print_result(result);
+        report(result);
+
+        auto result_v2 = run_benchmark(
+            "Hash computation (v2)",
+            1000,
+            size,
+            [&]() {
+                return HolographicHash::compute(data, params, AlgorithmVersion::v2);
+            }
+        );
+
+        report(result_v2);
+
+        const auto session = HolographicHash::prepare(params, AlgorithmVersion::v2);
+        auto result_prepared = run_benchmark(
+            "Hash computation (v2, prepared)",
+            1000,
+            size,
+            [&]() {
+                return HolographicHash::compute(data, session);
+            }
+        );
+
+        report(result_prepared);
+    }
+}
+
+void run_batch_hash_benchmarks() {
+    std::cout << "\n=== Batch Hash Benchmarks ===\n";
+
+    const size_t batch = 256;
+    const std::vector<size_t> sizes = {64, 256, 512};
+
+    for (size_t size : sizes) {
+        std::vector<std::vector<uint8_t>> messages;
+        std::vector<std::span<const uint8_t>> inputs;
+        for (size_t i = 0; i < batch; ++i) {
+            messages.push_back(generate_random_data(size));
+        }
+        inputs.assign(messages.begin(), messages.end());
+
+        std::vector<SessionParams> params(batch, SessionParams{
+            "127.0.0.1",
+            "192.168.1.1",
+            std::chrono::system_clock::now(),
+            {}
+        });
+        std::vector<Hash> out(batch, Hash{{}});
+
+        auto result = run_benchmark(
+            "Batch hash computation (256 messages)",
+            100,
+            size * batch,
+            [&]() {
+                HolographicHash::compute_batch(inputs, params, out);
+                // Escapes out, so no digest of the batch can be dropped
+                return out.data();
+            }
+        );
+
+        report(result);
+    }
+}
+
+void run_profile_benchmarks() {
+    std::cout << "\n=== Hash Profile Benchmarks ===\n";
+
+    SessionParams params{
+        "127.0.0.1",
+        "192.168.1.1",
+        std::chrono::system_clock::now(),
+        {}
+    };
+    const auto session = HolographicHash::prepare(params, AlgorithmVersion::v2);
+
+    for (size_t size : {64, 1024}) {
+        auto data = generate_random_data(size);
+
+        report(run_benchmark("Hash profile fast (128-bit, 4 rounds)", 1000, size, [&]() {
+            return FastHash::compute(data, session);
+        }));
+        report(run_benchmark("Hash profile standard (256-bit, 8 rounds)", 1000, size, [&]() {
+            return StandardHash::compute(data, session);
+        }));
+        report(run_benchmark("Hash profile strong (512-bit, 16 rounds)", 1000, size, [&]() {
+            return StrongHash::compute(data, session);
+        }));
+    }
+}
+
+void run_tree_hash_benchmarks() {
+    std::cout << "\n=== Tree Hash Benchmarks ===\n";
+
+    SessionParams params{
+        "127.0.0.1",
+        "192.168.1.1",
+        std::chrono::system_clock::now(),
+        {}
+    };
+
+    auto data = generate_random_data(size_t{256} << 20);
+
+    ThreadPool single(1);
+    for (ThreadPool* pool : {&single, &ThreadPool::shared()}) {
+        TreeParams tree;
+        tree.pool = pool;
+
+        auto result = run_benchmark(
+            "Tree hash computation (" + std::to_string(pool->concurrency()) + " threads)",
+            5,
+            data.size(),
+            [&]() {
+                return HolographicHash::compute_tree(data, params, tree);
+            }
+        );
+
+        report(result);
     }
 }
 
@@ -65,11 +191,22 @@ void run_nonce_benchmarks() {
             1000,
             size,
             [&]() {
-                EmergentNonce::generate(data, state);
+                return EmergentNonce::generate(data, state);
             }
         );
         
-        print_result(result);
+        report(result);
+
+        auto result_linear = run_benchmark(
+            "Nonce generation (linear)",
+            1000,
+            size,
+            [&]() {
+                return EmergentNonce::generate(data, state, AlgorithmVersion::v2, NonceMode::linear);
+            }
+        );
+
+        report(result_linear);
     }
 }
 
@@ -77,6 +214,7 @@ void run_keychain_benchmarks() {
     std::cout << "\n=== Keychain Benchmarks ===\n";
     
     Keychain keychain;
+    FlatKeychain flat_keychain;
     SessionParams params{
         "127.0.0.1",
         "192.168.1.1",
@@ -103,19 +241,142 @@ void run_keychain_benchmarks() {
             size,
             [&]() {
                 auto key = keychain.generate_key(data, params, state);
-                keychain.validate_key(key, params, state);
+                return keychain.validate_key(key, params, state);
             }
         );
         
-        print_result(result);
+        report(result);
+
+        auto result_flat = run_benchmark(
+            "Flat key generation and validation",
+            1000,
+            size,
+            [&]() {
+                auto key = flat_keychain.generate_key(data, params, state);
+                return flat_keychain.validate_key(key, params, state);
+            }
+        );
+
+        report(result_flat);
     }
+
+    // Re-keying: 10k keys per call, derived on the shared pool
+    const size_t batch = 10000;
+    std::vector<std::vector<uint8_t>> messages;
+    for (size_t i = 0; i < batch; ++i) {
+        messages.push_back(generate_random_data(64));
+    }
+    std::vector<std::span<const uint8_t>> inputs(messages.begin(), messages.end());
+    std::vector<SessionParams> batch_params(batch, params);
+    std::vector<SystemState> batch_states(batch, state);
+
+    auto result_batch = run_benchmark(
+        "Batch key generation (10000 keys, " + std::to_string(ThreadPool::shared().concurrency()) + " threads)",
+        10,
+        64 * batch,
+        [&]() {
+            Keychain rekeyed(AlgorithmVersion::v2, NonceMode::linear);
+            return rekeyed.generate_keys(inputs, batch_params, batch_states);
+        }
+    );
+
+    report(result_batch);
+
+    // Replayed or forged keys against a large store, with and without the
+    // key filter; each call validates one of 64k never-issued keys
+    std::vector<Key> forged(size_t{1} << 16, Key{{}});
+    for (auto& key : forged) {
+        auto bytes = generate_random_data(32);
+        std::copy(bytes.begin(), bytes.end(), key.get().begin());
+    }
+    for (size_t filter_keys : {size_t{0}, batch * 50}) {
+        KeychainOptions options;
+        options.version = AlgorithmVersion::v2;
+        options.nonce_mode = NonceMode::linear;
+        options.filter_keys = filter_keys;
+        Keychain store(options);
+        for (size_t i = 0; i < 50; ++i) {
+            store.generate_keys(inputs, batch_params, batch_states);
+            for (auto& message : messages) {
+                ++message[0];
+            }
+        }
+
+        size_t next = 0;
+        auto result_unknown = run_benchmark(
+            std::string("Unknown key validation (500000 keys, ") + (filter_keys ? "filtered)" : "unfiltered)"),
+            1000,
+            0,
+            [&]() {
+                return store.validate_key(forged[next++ & (forged.size() - 1)], params, state);
+            }
+        );
+
+        report(result_unknown);
+    }
+}
+
+void usage() {
+    std::cerr << "Usage: holohash_bench [--json <file>] [--baseline <file>] [--threshold <percent>]\n"
+                 "  --json       write the results as JSON\n"
+                 "  --baseline   compare medians with an earlier --json run; exits 1 on regressions\n"
+                 "  --threshold  slowdown counted as a regression (default 5)\n";
 }
 
-int main() {
+int main(int argc, char** argv) {
+    std::string json_path;
+    std::string baseline_path;
+    double threshold = 5;
+    for (int i = 1; i < argc; ++i) {
+        if (i + 1 < argc && std::strcmp(argv[i], "--json") == 0) {
+            json_path = argv[++i];
+        } else if (i + 1 < argc && std::strcmp(argv[i], "--baseline") == 0) {
+            baseline_path = argv[++i];
+        } else if (i + 1 < argc && std::strcmp(argv[i], "--threshold") == 0) {
+            threshold = std::atof(argv[++i]);
+        } else {
+            usage();
+            return 2;
+        }
+    }
+
     try {
+        // Read first so that a bad baseline fails before the long run
+        std::vector<BenchmarkResult> baseline;
+        if (!baseline_path.empty()) {
+            std::ifstream in(baseline_path);
+            if (!in) {
+                throw FileException("Cannot open " + baseline_path);
+            }
+            baseline = read_json(in);
+        }
+
+        std::cout << "Kernel level: "
+                  << platform::simd_level_name(platform::active_simd_level()) << "\n";
+
         run_hash_benchmarks();
+        run_batch_hash_benchmarks();
+        run_profile_benchmarks();
+        run_tree_hash_benchmarks();
         run_nonce_benchmarks();
         run_keychain_benchmarks();
+
+        if (!json_path.empty()) {
+            std::ofstream out(json_path);
+            write_json(out, results);
+            if (!out) {
+                throw FileException("Cannot write " + json_path);
+            }
+        }
+
+        if (!baseline_path.empty()) {
+            auto comparisons = compare(baseline, results, threshold / 100);
+            print_comparison(comparisons);
+            auto regressions = std::count_if(comparisons.begin(), comparisons.end(),
+                                             [](const Comparison& c) { return c.regression; });
+            std::cout << regressions << " of " << comparisons.size() << " benchmarks regressed\n";
+            return regressions == 0 ? 0 : 1;
+        }
         return 0;
     } catch (const std::exception& e) {
         std::cerr << "Error: " << e.what() << std::endl;
@@ -0,0 +1,283 @@
+#include <holohash/benchmark.hpp>
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <thread>
+
+using namespace holohash;
+using namespace holohash::benchmark;
+
+// Throughput and latency of a shared ConcurrentKeychain under a sweep of
+// thread count, read share, key-space size and hit ratio. Each thread runs
+// a random mix of generate_key (writes) and validate_key (reads) over a
+// preloaded key space for a fixed time. Writes re-derive a key of the
+// space, so the store stays the same size and a hit stays a hit; misses
+// validate keys that were never stored.
+//
+// Every configuration runs with 64 shards and with one shard, which is a
+// single reader/writer lock around one Keychain, so contention shows up as
+// the gap between the two.
+
+namespace {
+
+struct Config {
+    size_t shards;
+    size_t threads;
+    double reads;       // share of operations that are validate_key
+    size_t keys;
+    double hits;        // share of reads that find their key
+};
+
+struct Workload {
+    std::vector<std::vector<uint8_t>> inputs;
+    SystemState state;
+    std::vector<Key> keys;
+    std::vector<Key> missing;
+};
+
+struct Options {
+    size_t max_threads = std::max(std::thread::hardware_concurrency(), 1u);
+    std::chrono::milliseconds duration{200};
+    std::string json_path;
+    std::string baseline_path;
+    double threshold = 10;
+};
+
+const SessionParams& session_for(size_t i) {
+    // A handful of client sessions; each key is validated against its own
+    static const std::vector<SessionParams> sessions = [] {
+        std::vector<SessionParams> s;
+        for (int i = 0; i < 16; ++i) {
+            s.push_back(SessionParams{"10.0." + std::to_string(i) + ".1", "192.168.1.1",
+                                      std::chrono::system_clock::now(), {}});
+        }
+        return s;
+    }();
+    return sessions[i % sessions.size()];
+}
+
+Workload make_workload(size_t keys) {
+    Workload w;
+    w.state = SystemState{"content_hash", 50.0, 1024 * 1024, std::chrono::system_clock::now(), {}};
+
+    std::mt19937_64 rng(keys);
+    w.inputs.resize(keys);
+    for (size_t i = 0; i < keys; ++i) {
+        w.inputs[i].resize(32);
+        for (auto& byte : w.inputs[i]) {
+            byte = static_cast<uint8_t>(rng());
+        }
+    }
+
+    w.missing.resize(keys, Key{{}});
+    for (auto& key : w.missing) {
+        std::array<uint8_t, 32> bytes;
+        for (auto& byte : bytes) {
+            byte = static_cast<uint8_t>(rng());
+        }
+        key = Key(bytes);
+    }
+    return w;
+}
+
+ConcurrentKeychain& preload(std::unique_ptr<ConcurrentKeychain>& keychain, Workload& w, size_t shards) {
+    keychain = std::make_unique<ConcurrentKeychain>(shards, AlgorithmVersion::v2, NonceMode::linear);
+    w.keys.clear();
+    for (size_t i = 0; i < w.inputs.size(); ++i) {
+        w.keys.push_back(keychain->generate_key(w.inputs[i], session_for(i), w.state));
+    }
+    if (keychain->stats().keys != w.keys.size() ||
+        !keychain->validate_key(w.keys.back(), session_for(w.keys.size() - 1), w.state)) {
+        throw KeychainException("Preloaded keys do not validate");
+    }
+    return *keychain;
+}
+
+BenchmarkResult run(ConcurrentKeychain& keychain, const Workload& w, const Config& config,
+                    std::chrono::milliseconds duration) {
+    std::atomic<size_t> ready{0};
+    std::atomic<bool> go{false};
+    std::atomic<bool> stop{false};
+    std::vector<std::vector<double>> latencies(config.threads);
+    std::vector<uint64_t> operations(config.threads, 0);
+
+    auto worker = [&](size_t t) {
+        std::mt19937_64 rng(t * 7919 + config.keys);
+        std::uniform_real_distribution<double> coin(0.0, 1.0);
+        auto& samples = latencies[t];
+        samples.reserve(1 << 16);
+
+        ready.fetch_add(1);
+        while (!go.load(std::memory_order_acquire)) {
+        }
+
+        uint64_t ops = 0;
+        while (!stop.load(std::memory_order_relaxed)) {
+            const size_t i = rng() % config.keys;
+            const bool read = coin(rng) < config.reads;
+            const bool hit = coin(rng) < config.hits;
+
+            const auto start = std::chrono::steady_clock::now();
+            if (read) {
+                const Key& key = hit ? w.keys[i] : w.missing[i];
+                do_not_optimize(keychain.validate_key(key, session_for(i), w.state));
+            } else {
+                do_not_optimize(keychain.generate_key(w.inputs[i], session_for(i), w.state));
+            }
+            const auto end = std::chrono::steady_clock::now();
+            samples.push_back(std::chrono::duration<double, std::nano>(end - start).count());
+            ++ops;
+        }
+        operations[t] = ops;
+    };
+
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < config.threads; ++t) {
+        threads.emplace_back(worker, t);
+    }
+    while (ready.load() < config.threads) {
+        std::this_thread::yield();
+    }
+    const auto start = std::chrono::steady_clock::now();
+    go.store(true, std::memory_order_release);
+    std::this_thread::sleep_for(duration);
+    stop.store(true);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::vector<double> all;
+    uint64_t total = 0;
+    for (size_t t = 0; t < config.threads; ++t) {
+        all.insert(all.end(), latencies[t].begin(), latencies[t].end());
+        total += operations[t];
+    }
+    std::sort(all.begin(), all.end());
+
+    BenchmarkResult result{
+        "Keychain shards=" + std::to_string(config.shards) +
+            " threads=" + std::to_string(config.threads) +
+            " reads=" + std::to_string(static_cast<int>(config.reads * 100)) + "%" +
+            " keys=" + std::to_string(config.keys) +
+            " hits=" + std::to_string(static_cast<int>(config.hits * 100)) + "%",
+        0, 0, 0, total, 0
+    };
+    // ns_per_op is wall time per operation across all threads, the
+    // inverse of throughput; the percentiles are per-operation latency
+    result.ns_per_op = total > 0 ? seconds * 1e9 / total : 0;
+    result.avg_time_ms = result.ns_per_op / 1e6;
+    if (!all.empty()) {
+        result.min_time_ms = all.front() / 1e6;
+        result.max_time_ms = all.back() / 1e6;
+        result.p50_ns = percentile(all, 50);
+        result.p90_ns = percentile(all, 90);
+        result.p99_ns = percentile(all, 99);
+        result.p999_ns = percentile(all, 99.9);
+    }
+    return result;
+}
+
+void usage() {
+    std::cerr << "Usage: holohash_keychain_bench [--max-threads <n>] [--duration-ms <ms>]\n"
+                 "                              [--json <file>] [--baseline <file>] [--threshold <percent>]\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        if (i + 1 < argc && std::strcmp(argv[i], "--max-threads") == 0) {
+            options.max_threads = std::max<size_t>(std::strtoull(argv[++i], nullptr, 10), 1);
+        } else if (i + 1 < argc && std::strcmp(argv[i], "--duration-ms") == 0) {
+            options.duration = std::chrono::milliseconds(std::strtoull(argv[++i], nullptr, 10));
+        } else if (i + 1 < argc && std::strcmp(argv[i], "--json") == 0) {
+            options.json_path = argv[++i];
+        } else if (i + 1 < argc && std::strcmp(argv[i], "--baseline") == 0) {
+            options.baseline_path = argv[++i];
+        } else if (i + 1 < argc && std::strcmp(argv[i], "--threshold") == 0) {
+            options.threshold = std::atof(argv[++i]);
+        } else {
+            usage();
+            return 2;
+        }
+    }
+
+    try {
+        std::vector<BenchmarkResult> baseline;
+        if (!options.baseline_path.empty()) {
+            std::ifstream in(options.baseline_path);
+            if (!in) {
+                throw FileException("Cannot open " + options.baseline_path);
+            }
+            baseline = read_json(in);
+        }
+
+        // Powers of two up to the limit, plus the limit itself
+        std::vector<size_t> thread_counts;
+        for (size_t n = 1; n < options.max_threads; n *= 2) {
+            thread_counts.push_back(n);
+        }
+        thread_counts.push_back(options.max_threads);
+
+        std::cout << "=== Keychain Scaling (" << options.duration.count() << " ms per configuration) ===\n"
+                  << std::setw(7) << "shards" << std::setw(8) << "threads" << std::setw(7) << "reads"
+                  << std::setw(9) << "keys" << std::setw(6) << "hits"
+                  << std::setw(12) << "Mops/s" << std::setw(10) << "p50 ns"
+                  << std::setw(10) << "p99 ns" << std::setw(11) << "p99.9 ns" << "\n";
+
+        std::vector<BenchmarkResult> results;
+        for (size_t keys : {size_t{1000}, size_t{100000}}) {
+            Workload workload = make_workload(keys);
+            for (size_t shards : {ConcurrentKeychain::default_shard_count, size_t{1}}) {
+                std::unique_ptr<ConcurrentKeychain> holder;
+                auto& keychain = preload(holder, workload, shards);
+                for (double reads : {0.0, 0.5, 0.9, 1.0}) {
+                    for (double hits : {1.0, 0.5}) {
+                        if (reads == 0.0 && hits != 1.0) {
+                            continue;   // no reads, so the hit ratio is moot
+                        }
+                        for (size_t threads : thread_counts) {
+                            Config config{shards, threads, reads, keys, hits};
+                            auto result = run(keychain, workload, config, options.duration);
+                            std::cout << std::setw(7) << shards << std::setw(8) << threads
+                                      << std::setw(6) << static_cast<int>(reads * 100) << "%"
+                                      << std::setw(9) << keys
+                                      << std::setw(5) << static_cast<int>(hits * 100) << "%"
+                                      << std::fixed << std::setprecision(3)
+                                      << std::setw(12) << 1e3 / result.ns_per_op
+                                      << std::setprecision(0)
+                                      << std::setw(10) << result.p50_ns
+                                      << std::setw(10) << result.p99_ns
+                                      << std::setw(11) << result.p999_ns << "\n";
+                            results.push_back(std::move(result));
+                        }
+                    }
+                }
+            }
+        }
+
+        if (!options.json_path.empty()) {
+            std::ofstream out(options.json_path);
+            write_json(out, results);
+            if (!out) {
+                throw FileException("Cannot write " + options.json_path);
+            }
+        }
+
+        if (!options.baseline_path.empty()) {
+            auto comparisons = compare(baseline, results, options.threshold / 100);
+            print_comparison(comparisons);
+            auto regressions = std::count_if(comparisons.begin(), comparisons.end(),
+                                             [](const Comparison& c) { return c.regression; });
+            std::cout << regressions << " of " << comparisons.size() << " configurations regressed\n";
+            return regressions == 0 ? 0 : 1;
+        }
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
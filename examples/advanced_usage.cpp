@@ -105,18 +105,22 @@ void demonstrate_nonce_evolution() {
         {}
     };
     
-    // Generate initial nonce
-    auto nonce1 = EmergentNonce::generate(data, state);
+    // Each link is chained to the previous one
+    NonceChain chain;
+    auto nonce1 = chain.next(data, state);
     print_hex("Initial Nonce", nonce1.get());
     
     // Evolve system state
     state.cpu_load = 45.0;
     state.memory_usage = 768*1024;
-    state.previous_nonce = std::vector<uint8_t>(nonce1.get().begin(), nonce1.get().end());
     
     // Generate evolved nonce
-    auto nonce2 = EmergentNonce::generate(data, state);
+    auto nonce2 = chain.next(data, state);
     print_hex("Evolved Nonce", nonce2.get());
+
+    // Roll back to the first link
+    chain.rollback(1);
+    print_hex("Rolled Back Nonce", chain.head().get());
 }
 
 // Example of performance benchmarking
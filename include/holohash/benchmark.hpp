@@ -1,73 +1,452 @@
 #pragma once
 #include "core.hpp"
+#include <algorithm>
+#include <cctype>
 #include <chrono>
+#include <cmath>
+#include <cstdint>
 #include <vector>
 #include <string>
 #include <iostream>
 #include <iomanip>
 #include <functional>
+#include <istream>
+#include <ostream>
+#include <type_traits>
+#include <utility>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
 
 namespace holohash {
 namespace benchmark {
 
+// Keeps the compiler from discarding value, or the computation producing it
+template<typename T>
+inline void do_not_optimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    const volatile char* p = reinterpret_cast<const volatile char*>(&value);
+    (void)*p;
+    _ReadWriteBarrier();
+#endif
+}
+
+// Keeps the compiler from moving memory accesses across this point
+inline void clobber_memory() {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : : "memory");
+#else
+    _ReadWriteBarrier();
+#endif
+}
+
+// Time stamp counter, or 0 where the architecture has none. On x86-64 it
+// ticks at the nominal frequency whatever the current clock, so cycle
+// figures are reference cycles.
+inline uint64_t cycle_count() noexcept {
+#if defined(HOLOHASH_ARCH_X64)
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+inline constexpr bool have_cycle_count() noexcept {
+#if defined(HOLOHASH_ARCH_X64)
+    return true;
+#else
+    return false;
+#endif
+}
+
+struct BenchmarkOptions {
+    // Untimed calls before measuring, to warm caches, branch predictors
+    // and the CPU clock
+    std::chrono::nanoseconds warmup = std::chrono::milliseconds(20);
+
+    // Each sample times enough back-to-back calls to last at least this
+    // long, far above the clock's resolution
+    std::chrono::nanoseconds min_sample_time = std::chrono::microseconds(100);
+
+    // Stops taking samples once this much time has been spent
+    std::chrono::nanoseconds max_time = std::chrono::seconds(2);
+};
+
 struct BenchmarkResult {
     std::string name;
     double avg_time_ms;
     double min_time_ms;
     double max_time_ms;
-    size_t iterations;
+    size_t iterations;          // timed samples
     size_t data_size;
+
+    size_t batch = 1;           // calls per sample
+    double ns_per_op = 0;       // mean
+    double p50_ns = 0;
+    double p90_ns = 0;
+    double p99_ns = 0;
+    double p999_ns = 0;
+    double cycles_per_byte = 0; // 0 without a cycle counter
+    double mb_per_s = 0;
 };
 
+// Nearest-rank percentile (0-100) of ascending values
+inline double percentile(const std::vector<double>& sorted, double p) {
+    if (sorted.empty()) {
+        return 0;
+    }
+    size_t rank = static_cast<size_t>(std::ceil(p / 100.0 * sorted.size()));
+    return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+}
+
+namespace detail {
+
+template<typename Func>
+inline void invoke(Func& func) {
+    if constexpr (std::is_void_v<std::invoke_result_t<Func&>>) {
+        func();
+        clobber_memory();
+    } else {
+        auto result = func();
+        do_not_optimize(result);
+    }
+}
+
+} // namespace detail
+
+// Takes up to iterations samples of func. Each sample times a batch of
+// calls sized during warmup so that it lasts at least min_sample_time;
+// timings are per call, and percentiles are over the per-call means of
+// the samples. A value returned by func is passed to do_not_optimize.
 template<typename Func>
 BenchmarkResult run_benchmark(
     const std::string& name,
     size_t iterations,
     size_t data_size,
-    Func&& func
+    Func&& func,
+    const BenchmarkOptions& options = {}
 ) {
-    std::vector<double> timings;
+    using clock = std::chrono::steady_clock;
+    iterations = std::max<size_t>(iterations, 1);
+
+    // Warmup doubles the batch until one batch outlasts min_sample_time
+    size_t batch = 1;
+    const auto warmup_end = clock::now() + options.warmup;
+    do {
+        auto start = clock::now();
+        for (size_t i = 0; i < batch; ++i) {
+            detail::invoke(func);
+        }
+        if (clock::now() - start < options.min_sample_time) {
+            batch *= 2;
+        }
+    } while (clock::now() < warmup_end);
+
+    std::vector<double> timings;    // ns per call, one per sample
     timings.reserve(iterations);
+    uint64_t cycles = 0;
+    const auto deadline = clock::now() + options.max_time;
 
-    for (size_t i = 0; i < iterations; ++i) {
-        auto start = std::chrono::high_resolution_clock::now();
-        func();
-        auto end = std::chrono::high_resolution_clock::now();
-        
-        double duration = std::chrono::duration<double, std::milli>(end - start).count();
-        timings.push_back(duration);
+    for (size_t s = 0; s < iterations; ++s) {
+        const uint64_t c0 = cycle_count();
+        const auto start = clock::now();
+        for (size_t i = 0; i < batch; ++i) {
+            detail::invoke(func);
+        }
+        const auto end = clock::now();
+        cycles += cycle_count() - c0;
+
+        timings.push_back(std::chrono::duration<double, std::nano>(end - start).count() / batch);
+        if (end >= deadline) {
+            break;
+        }
     }
 
-    double total = 0.0;
-    double min_time = timings[0];
-    double max_time = timings[0];
+    BenchmarkResult result{name, 0, 0, 0, timings.size(), data_size};
+    result.batch = batch;
 
-    for (double time : timings) {
-        total += time;
-        min_time = std::min(min_time, time);
-        max_time = std::max(max_time, time);
+    double total = 0;
+    for (double t : timings) {
+        total += t;
     }
+    result.ns_per_op = total / timings.size();
 
-    return BenchmarkResult{
-        name,
-        total / iterations,
-        min_time,
-        max_time,
-        iterations,
-        data_size
-    };
+    std::sort(timings.begin(), timings.end());
+    result.avg_time_ms = result.ns_per_op / 1e6;
+    result.min_time_ms = timings.front() / 1e6;
+    result.max_time_ms = timings.back() / 1e6;
+    result.p50_ns = percentile(timings, 50);
+    result.p90_ns = percentile(timings, 90);
+    result.p99_ns = percentile(timings, 99);
+    result.p999_ns = percentile(timings, 99.9);
+    if (data_size > 0) {
+        if (have_cycle_count()) {
+            result.cycles_per_byte = static_cast<double>(cycles) /
+                (static_cast<double>(timings.size()) * batch * data_size);
+        }
+        result.mb_per_s = data_size * 1e3 / result.ns_per_op;
+    }
+    return result;
 }
 
 inline void print_result(const BenchmarkResult& result) {
     std::cout << "\nBenchmark: " << result.name << "\n"
               << "Data size: " << result.data_size << " bytes\n"
-              << "Iterations: " << result.iterations << "\n"
-              << "Average time: " << std::fixed << std::setprecision(3) << result.avg_time_ms << " ms\n"
-              << "Min time: " << result.min_time_ms << " ms\n"
-              << "Max time: " << result.max_time_ms << " ms\n"
-              << "Throughput: " << std::fixed << std::setprecision(2)
-              << (result.data_size * 1000.0) / (result.avg_time_ms * 1024 * 1024)
-              << " MB/s\n";
+              << "Samples: " << result.iterations << " x " << result.batch << " calls\n"
+              << "Average time: " << std::fixed << std::setprecision(1) << result.ns_per_op << " ns\n"
+              << "Percentiles: p50 " << result.p50_ns << " ns, p90 " << result.p90_ns
+              << " ns, p99 " << result.p99_ns << " ns, p99.9 " << result.p999_ns << " ns\n"
+              << "Min time: " << result.min_time_ms * 1e6 << " ns\n"
+              << "Max time: " << result.max_time_ms * 1e6 << " ns\n";
+    if (result.data_size > 0) {
+        std::cout << "Throughput: " << std::setprecision(2) << result.mb_per_s << " MB/s";
+        if (result.cycles_per_byte > 0) {
+            std::cout << ", " << std::setprecision(3) << result.cycles_per_byte << " cycles/byte";
+        }
+        std::cout << "\n";
+    }
+}
+
+// Writes results as a JSON document that read_json() accepts, for example
+// as the baseline of a later compare()
+inline void write_json(std::ostream& out, const std::vector<BenchmarkResult>& results) {
+    auto escape = [](const std::string& text) {
+        std::string escaped;
+        for (char c : text) {
+            if (c == '"' || c == '\\') {
+                escaped += '\\';
+            }
+            escaped += c;
+        }
+        return escaped;
+    };
+
+    out << "{\n  \"context\": {\"simd\": \""
+        << platform::simd_level_name(platform::active_simd_level())
+        << "\", \"cycle_counter\": " << (have_cycle_count() ? "true" : "false") << "},\n"
+        << "  \"benchmarks\": [";
+    out << std::setprecision(6) << std::defaultfloat;
+    for (size_t i = 0; i < results.size(); ++i) {
+        const auto& r = results[i];
+        out << (i == 0 ? "\n" : ",\n")
+            << "    {\"name\": \"" << escape(r.name) << "\""
+            << ", \"data_size\": " << r.data_size
+            << ", \"samples\": " << r.iterations
+            << ", \"batch\": " << r.batch
+            << ", \"ns_per_op\": " << r.ns_per_op
+            << ", \"p50_ns\": " << r.p50_ns
+            << ", \"p90_ns\": " << r.p90_ns
+            << ", \"p99_ns\": " << r.p99_ns
+            << ", \"p999_ns\": " << r.p999_ns
+            << ", \"min_ns\": " << r.min_time_ms * 1e6
+            << ", \"max_ns\": " << r.max_time_ms * 1e6
+            << ", \"cycles_per_byte\": " << r.cycles_per_byte
+            << ", \"mb_per_s\": " << r.mb_per_s << "}";
+    }
+    out << "\n  ]\n}\n";
+}
+
+namespace detail {
+
+// Reader for the documents write_json() produces: objects, arrays,
+// strings, numbers and literals, with unknown members skipped
+class JsonReader {
+public:
+    explicit JsonReader(std::istream& in) : in_(in) {}
+
+    std::vector<BenchmarkResult> read() {
+        std::vector<BenchmarkResult> results;
+        object([&](const std::string& key) {
+            if (key != "benchmarks") {
+                skip();
+                return;
+            }
+            array([&] {
+                BenchmarkResult r{"", 0, 0, 0, 0, 0};
+                object([&](const std::string& field) {
+                    if (field == "name") {
+                        r.name = string();
+                        return;
+                    }
+                    const double value = number();
+                    if (field == "data_size") r.data_size = static_cast<size_t>(value);
+                    else if (field == "samples") r.iterations = static_cast<size_t>(value);
+                    else if (field == "batch") r.batch = static_cast<size_t>(value);
+                    else if (field == "ns_per_op") r.ns_per_op = value;
+                    else if (field == "p50_ns") r.p50_ns = value;
+                    else if (field == "p90_ns") r.p90_ns = value;
+                    else if (field == "p99_ns") r.p99_ns = value;
+                    else if (field == "p999_ns") r.p999_ns = value;
+                    else if (field == "min_ns") r.min_time_ms = value / 1e6;
+                    else if (field == "max_ns") r.max_time_ms = value / 1e6;
+                    else if (field == "cycles_per_byte") r.cycles_per_byte = value;
+                    else if (field == "mb_per_s") r.mb_per_s = value;
+                });
+                r.avg_time_ms = r.ns_per_op / 1e6;
+                results.push_back(std::move(r));
+            });
+        });
+        return results;
+    }
+
+private:
+    std::istream& in_;
+
+    [[noreturn]] void fail() {
+        throw InvalidInputException("Malformed benchmark JSON");
+    }
+
+    char peek() {
+        in_ >> std::ws;
+        int c = in_.peek();
+        if (c == std::char_traits<char>::eof()) {
+            fail();
+        }
+        return static_cast<char>(c);
+    }
+
+    void expect(char c) {
+        if (peek() != c) {
+            fail();
+        }
+        in_.get();
+    }
+
+    template<typename Member>
+    void object(Member&& member) {
+        expect('{');
+        if (peek() == '}') {
+            in_.get();
+            return;
+        }
+        do {
+            std::string key = string();
+            expect(':');
+            member(key);
+        } while (separator('}'));
+    }
+
+    template<typename Element>
+    void array(Element&& element) {
+        expect('[');
+        if (peek() == ']') {
+            in_.get();
+            return;
+        }
+        do {
+            element();
+        } while (separator(']'));
+    }
+
+    // Consumes ',' (true) or the closing character (false)
+    bool separator(char close) {
+        char c = peek();
+        in_.get();
+        if (c == ',') {
+            return true;
+        }
+        if (c != close) {
+            fail();
+        }
+        return false;
+    }
+
+    std::string string() {
+        expect('"');
+        std::string text;
+        for (int c; (c = in_.get()) != '"';) {
+            if (c == std::char_traits<char>::eof()) {
+                fail();
+            }
+            if (c == '\\') {
+                c = in_.get();
+                if (c == std::char_traits<char>::eof()) {
+                    fail();
+                }
+            }
+            text += static_cast<char>(c);
+        }
+        return text;
+    }
+
+    double number() {
+        peek();
+        double value;
+        if (!(in_ >> value)) {
+            fail();
+        }
+        return value;
+    }
+
+    void skip() {
+        char c = peek();
+        if (c == '{') {
+            object([&](const std::string&) { skip(); });
+        } else if (c == '[') {
+            array([&] { skip(); });
+        } else if (c == '"') {
+            string();
+        } else if (c == 't' || c == 'f' || c == 'n') {
+            while (std::isalpha(in_.peek())) {
+                in_.get();
+            }
+        } else {
+            number();
+        }
+    }
+};
+
+} // namespace detail
+
+inline std::vector<BenchmarkResult> read_json(std::istream& in) {
+    return detail::JsonReader(in).read();
+}
+
+struct Comparison {
+    std::string name;
+    size_t data_size;
+    double baseline_ns;     // p50
+    double current_ns;      // p50
+    double change;          // current / baseline - 1
+    bool regression;
+};
+
+// Matches results by name and data size and compares their medians, which
+// unlike the mean ignore the odd descheduled sample. A change above
+// threshold (0.05 = 5% slower) is a regression. Results present in only
+// one run are left out.
+inline std::vector<Comparison> compare(
+    const std::vector<BenchmarkResult>& baseline,
+    const std::vector<BenchmarkResult>& current,
+    double threshold = 0.05
+) {
+    std::vector<Comparison> comparisons;
+    for (const auto& now : current) {
+        auto before = std::find_if(baseline.begin(), baseline.end(), [&](const BenchmarkResult& r) {
+            return r.name == now.name && r.data_size == now.data_size;
+        });
+        if (before == baseline.end() || before->p50_ns <= 0) {
+            continue;
+        }
+        const double change = now.p50_ns / before->p50_ns - 1;
+        comparisons.push_back(Comparison{now.name, now.data_size, before->p50_ns, now.p50_ns,
+                                         change, change > threshold});
+    }
+    return comparisons;
+}
+
+inline void print_comparison(const std::vector<Comparison>& comparisons) {
+    std::cout << "\n=== Baseline Comparison (p50) ===\n";
+    for (const auto& c : comparisons) {
+        std::cout << (c.regression ? "REGRESSION " : "           ")
+                  << std::showpos << std::fixed << std::setprecision(1) << std::setw(7)
+                  << c.change * 100 << "%" << std::noshowpos
+                  << "  " << c.baseline_ns << " -> " << c.current_ns << " ns  "
+                  << c.name << " (" << c.data_size << " bytes)\n";
+    }
 }
 
 } // namespace benchmark
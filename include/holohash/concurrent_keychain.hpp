@@ -0,0 +1,177 @@
+#pragma once
+#include "keychain.hpp"
+#include "platform.hpp"
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <bit>
+
+namespace holohash {
+
+// Thread-safe keychain. The key space is split by key bits into a
+// power-of-two number of shards, each a Keychain guarded by its own
+// reader/writer lock and padded to a cache line so neighbouring shards do
+// not share lines. Hash and nonce work happens before any lock is taken;
+// generate_key() then locks only the owning shard exclusively and
+// validate_key() takes it shared, so readers never block each other.
+class ConcurrentKeychain {
+public:
+    static constexpr size_t default_shard_count = 64;
+
+    explicit ConcurrentKeychain(
+        size_t shard_count = default_shard_count,
+        AlgorithmVersion version = AlgorithmVersion::v1,
+        NonceMode nonce_mode = NonceMode::recursive
+    ) : ConcurrentKeychain(KeychainOptions{version, nonce_mode}, shard_count) {}
+
+    // Key and byte budgets and the filter size are divided evenly between
+    // the shards
+    explicit ConcurrentKeychain(const KeychainOptions& options, size_t shard_count = default_shard_count)
+        : shard_count_(std::bit_ceil(std::max<size_t>(shard_count, 1))),
+          shards_(std::make_unique<Shard[]>(shard_count_)),
+          deriver_(options.version, options.nonce_mode) {
+        KeychainOptions shard_options = options;
+        shard_options.max_keys = (options.max_keys + shard_count_ - 1) / shard_count_;
+        shard_options.max_bytes = (options.max_bytes + shard_count_ - 1) / shard_count_;
+        shard_options.filter_keys = (options.filter_keys + shard_count_ - 1) / shard_count_;
+        for (size_t i = 0; i < shard_count_; ++i) {
+            shards_[i].keychain = Keychain(shard_options);
+        }
+    }
+
+    Key generate_key(
+        std::span<const uint8_t> input,
+        const SessionParams& params,
+        const SystemState& state
+    ) {
+        metrics::ScopedTimer timer(metrics::Op::generate_key, input.size());
+        auto key = deriver_.derive_key(input, params, state);
+        store_key(key, params, state);
+        return key;
+    }
+
+    Key generate_key(
+        std::span<const uint8_t> input,
+        SessionParams&& params,
+        SystemState&& state
+    ) {
+        metrics::ScopedTimer timer(metrics::Op::generate_key, input.size());
+        auto key = deriver_.derive_key(input, params, state);
+        store_key(key, std::move(params), std::move(state));
+        return key;
+    }
+
+    Key generate_key(
+        std::span<const uint8_t> input,
+        const SessionView& params,
+        const StateView& state
+    ) {
+        metrics::ScopedTimer timer(metrics::Op::generate_key, input.size());
+        auto key = deriver_.derive_key(input, params, state);
+        store_key(key, params.to_params(), state.to_state());
+        return key;
+    }
+
+    Key generate_key(const Keychain::KeyStream& stream) {
+        metrics::ScopedTimer timer(metrics::Op::generate_key, stream.size());
+        auto key = Keychain::derive_key(stream);
+        store_key(key, stream.params(), stream.state());
+        return key;
+    }
+
+    bool validate_key(
+        const Key& key,
+        const SessionView& params,
+        const StateView& state
+    ) const {
+        metrics::ScopedTimer timer(metrics::Op::validate_key);
+        const auto& shard = shard_for(key);
+        std::shared_lock lock(shard.mutex);
+        const bool valid = shard.keychain.check_key(key, params, state);
+        timer.fail(!valid);
+        return valid;
+    }
+
+    // Runs expiry on every shard, one shard lock at a time
+    void expire(std::chrono::system_clock::time_point now = std::chrono::system_clock::now()) {
+        for (size_t i = 0; i < shard_count_; ++i) {
+            std::unique_lock lock(shards_[i].mutex);
+            shards_[i].keychain.expire(now);
+        }
+    }
+
+    // Sum over shards; each shard is read under its own lock, so the total
+    // is not an atomic snapshot
+    KeychainStats stats() const {
+        KeychainStats total;
+        for (size_t i = 0; i < shard_count_; ++i) {
+            std::shared_lock lock(shards_[i].mutex);
+            auto shard = shards_[i].keychain.stats();
+            total.keys += shard.keys;
+            total.bytes += shard.bytes;
+            total.evictions += shard.evictions;
+            total.expirations += shard.expirations;
+        }
+        return total;
+    }
+
+    // Shard tables combined: keys, buckets and empty buckets are summed,
+    // longest_chain is the longest in any shard
+    TableStats table_stats() const {
+        TableStats total;
+        for (size_t i = 0; i < shard_count_; ++i) {
+            std::shared_lock lock(shards_[i].mutex);
+            auto shard = shards_[i].keychain.table_stats();
+            total.keys += shard.keys;
+            total.buckets += shard.buckets;
+            total.empty_buckets += shard.empty_buckets;
+            total.longest_chain = std::max(total.longest_chain, shard.longest_chain);
+        }
+        total.load_factor = total.buckets ? static_cast<double>(total.keys) / total.buckets : 0;
+        return total;
+    }
+
+    // Shard filters combined: sizes and counts are summed, the false
+    // positive rate is the mean over shards, which see equal key shares
+    FilterStats filter_stats() const {
+        FilterStats total;
+        for (size_t i = 0; i < shard_count_; ++i) {
+            std::shared_lock lock(shards_[i].mutex);
+            auto shard = shards_[i].keychain.filter_stats();
+            total.bytes += shard.bytes;
+            total.capacity += shard.capacity;
+            total.inserted += shard.inserted;
+            total.rebuilds += shard.rebuilds;
+            total.false_positive_rate += shard.false_positive_rate / shard_count_;
+        }
+        return total;
+    }
+
+    size_t shard_count() const noexcept { return shard_count_; }
+    AlgorithmVersion version() const noexcept { return deriver_.version(); }
+    NonceMode nonce_mode() const noexcept { return deriver_.nonce_mode(); }
+
+private:
+    struct alignas(platform::get_cache_line_size()) Shard {
+        mutable std::shared_mutex mutex;
+        Keychain keychain;
+    };
+
+    size_t shard_count_;
+    std::unique_ptr<Shard[]> shards_;
+    Keychain deriver_;  // key derivation settings only, never stores
+
+    // Keys are uniformly distributed, so their leading bytes pick the shard
+    Shard& shard_for(const Key& key) const noexcept {
+        return shards_[detail::load_le64(key.get().data()) & (shard_count_ - 1)];
+    }
+
+    // The context is copied before the shard lock is taken
+    void store_key(const Key& key, SessionParams params, SystemState state) {
+        auto& shard = shard_for(key);
+        std::unique_lock lock(shard.mutex);
+        shard.keychain.store_key(key, std::move(params), std::move(state));
+    }
+};
+
+} // namespace holohash
@@ -2,7 +2,16 @@
 #include "hash.hpp"
 #include "nonce.hpp"
 #include "keychain.hpp"
+#include "concurrent_keychain.hpp"
+#include "flat_keychain.hpp"
+#include "key_snapshot.hpp"
+#include "key_log.hpp"
+#include "key_filter.hpp"
+#include "file_hash.hpp"
 #include "types.hpp"
+#include "generator.hpp"
+#include "thread_pool.hpp"
+#include "metrics.hpp"
 #include "exceptions.hpp"
 
 // Main include file for the library
@@ -0,0 +1,106 @@
+#pragma once
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string_view>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#endif
+
+namespace holohash {
+namespace platform {
+
+// Instruction set levels the dispatched kernels are built for. Each level
+// implies all lower ones.
+enum class SimdLevel : uint8_t {
+    scalar = 0,
+    sse2 = 1,
+    avx2 = 2,
+    avx512 = 3
+};
+
+// Per-function instruction set enablement, so wider kernels can live in the
+// same headers as the baseline code and be selected at run time
+#if (defined(__x86_64__) || defined(_M_X64)) && (defined(__GNUC__) || defined(__clang__))
+    #define HOLOHASH_TARGET_AVX2 __attribute__((target("avx2")))
+    #define HOLOHASH_TARGET_AVX512 __attribute__((target("avx2,avx512f,avx512bw,avx512vl")))
+#else
+    #define HOLOHASH_TARGET_AVX2
+    #define HOLOHASH_TARGET_AVX512
+#endif
+
+constexpr std::string_view simd_level_name(SimdLevel level) noexcept {
+    switch (level) {
+        case SimdLevel::sse2: return "sse2";
+        case SimdLevel::avx2: return "avx2";
+        case SimdLevel::avx512: return "avx512";
+        default: return "scalar";
+    }
+}
+
+// Parses the names produced by simd_level_name(); false if unrecognised
+constexpr bool parse_simd_level(std::string_view name, SimdLevel& level) noexcept {
+    for (auto candidate : {SimdLevel::scalar, SimdLevel::sse2, SimdLevel::avx2, SimdLevel::avx512}) {
+        if (name == simd_level_name(candidate)) {
+            level = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Highest level supported by both the CPU and the operating system
+inline SimdLevel detect_simd_level() noexcept {
+#if defined(__x86_64__) || defined(_M_X64)
+    #if defined(_MSC_VER) && !defined(__clang__)
+        int regs[4];
+        __cpuid(regs, 0);
+        const int max_leaf = regs[0];
+
+        __cpuid(regs, 1);
+        const bool osxsave = (regs[2] & (1 << 27)) != 0;
+        const bool avx = (regs[2] & (1 << 28)) != 0;
+        if (!osxsave || !avx || max_leaf < 7) {
+            return SimdLevel::sse2;
+        }
+
+        const unsigned long long xcr0 = _xgetbv(0);
+        if ((xcr0 & 0x6) != 0x6) {
+            return SimdLevel::sse2;
+        }
+
+        __cpuidex(regs, 7, 0);
+        const bool avx2 = (regs[1] & (1 << 5)) != 0;
+        const bool avx512 = (regs[1] & (1 << 16)) != 0 &&   // F
+                            (regs[1] & (1 << 30)) != 0 &&   // BW
+                            (regs[1] & (1 << 31)) != 0 &&   // VL
+                            (xcr0 & 0xE6) == 0xE6;
+        if (avx512) {
+            return SimdLevel::avx512;
+        }
+        return avx2 ? SimdLevel::avx2 : SimdLevel::sse2;
+    #else
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") &&
+            __builtin_cpu_supports("avx512vl")) {
+            return SimdLevel::avx512;
+        }
+        if (__builtin_cpu_supports("avx2")) {
+            return SimdLevel::avx2;
+        }
+        return SimdLevel::sse2;
+    #endif
+#else
+    return SimdLevel::scalar;
+#endif
+}
+
+// Level requested through the HOLOHASH_SIMD environment variable, if any
+inline bool requested_simd_level(SimdLevel& level) noexcept {
+    const char* value = std::getenv("HOLOHASH_SIMD");
+    return value != nullptr && parse_simd_level(std::string_view(value, std::strlen(value)), level);
+}
+
+} // namespace platform
+} // namespace holohash
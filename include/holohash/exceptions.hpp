@@ -24,4 +24,9 @@ public:
     explicit KeychainException(const std::string& msg) : HoloHashException(msg) {}
 };
 
+class FileException : public HoloHashException {
+public:
+    explicit FileException(const std::string& msg) : HoloHashException(msg) {}
+};
+
 } // namespace holohash
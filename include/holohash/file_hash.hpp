@@ -0,0 +1,391 @@
+#pragma once
+#include "hash.hpp"
+#include "platform.hpp"
+#include "exceptions.hpp"
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace holohash {
+
+struct FileHashOptions {
+    // Bytes per read; a multiple of HashStream::block_size, which also
+    // keeps O_DIRECT reads aligned
+    size_t chunk_size = size_t{256} << 10;
+
+    // Reads kept in flight, and the number of chunk buffers
+    unsigned queue_depth = 8;
+
+    // Read through io_uring where available; false forces the pread path
+    bool io_uring = true;
+
+    // io_uring reads bypass the page cache with O_DIRECT where the file
+    // system allows it
+    bool direct = true;
+};
+
+// Hashes files as a HashStream over their contents, so a file's digest
+// equals HashStream(params) fed the whole file.
+//
+// With io_uring, queue_depth reads into registered buffers stay in flight.
+// Chunks may complete in any order; each is hashed as soon as all earlier
+// chunks have been, and its buffer immediately carries the next read, so
+// the disk keeps working while the CPU hashes. Where io_uring is missing or
+// refused, chunks are read one at a time with pread, or std::ifstream off
+// POSIX.
+//
+// A FileHasher keeps its ring and buffers across files and is not
+// thread-safe; use one per thread, or a FileHashPool.
+class FileHasher {
+public:
+    enum class Backend : uint8_t {
+        io_uring,
+        pread
+    };
+
+    explicit FileHasher(const FileHashOptions& options = {}) : options_(options) {
+        if (options_.chunk_size == 0 || options_.chunk_size % HashStream::block_size != 0) {
+            throw InvalidInputException("File chunk size must be a positive multiple of the stream block size");
+        }
+        options_.queue_depth = std::clamp(options_.queue_depth, 1u, 256u);
+        buffers_ = platform::PageBuffer(options_.chunk_size * options_.queue_depth, false);
+        lengths_.assign(options_.queue_depth, 0);
+        ready_.assign(options_.queue_depth, false);
+#if defined(HOLOHASH_HAVE_IO_URING)
+        if (options_.io_uring) {
+            init_ring();
+        }
+#endif
+    }
+
+    FileHasher(const FileHasher&) = delete;
+    FileHasher& operator=(const FileHasher&) = delete;
+
+    Hash hash(const std::string& path, const SessionView& params) {
+        HashStream stream(params);
+#if defined(HOLOHASH_HAVE_IO_URING)
+        if (ring_) {
+            read_ring(path, stream);
+            return stream.finalize();
+        }
+#endif
+        read_blocking(path, stream);
+        return stream.finalize();
+    }
+
+    // Hashes in the background on FileHashPool::shared(), so concurrent
+    // calls share its rings and buffers instead of making their own
+    static std::future<Hash> hash_async(std::string path, SessionParams params);
+
+    Backend backend() const noexcept {
+#if defined(HOLOHASH_HAVE_IO_URING)
+        if (ring_) {
+            return Backend::io_uring;
+        }
+#endif
+        return Backend::pread;
+    }
+
+    const FileHashOptions& options() const noexcept { return options_; }
+
+private:
+    FileHashOptions options_;
+    platform::PageBuffer buffers_;
+    std::vector<size_t> lengths_;   // valid bytes per buffer once ready
+    std::vector<bool> ready_;
+#if defined(HOLOHASH_HAVE_IO_URING)
+    std::unique_ptr<platform::IoUring> ring_;
+#endif
+
+    uint8_t* buffer(uint64_t chunk) noexcept {
+        return buffers_.data() + (chunk % options_.queue_depth) * options_.chunk_size;
+    }
+
+#if defined(__linux__) || defined(__APPLE__)
+    struct Descriptor {
+        int fd = -1;
+
+        Descriptor() noexcept = default;
+        Descriptor(const Descriptor&) = delete;
+        Descriptor& operator=(const Descriptor&) = delete;
+        ~Descriptor() {
+            if (fd >= 0) {
+                ::close(fd);
+            }
+        }
+    };
+
+    static void open_file(Descriptor& file, const std::string& path, int flags) {
+        file.fd = ::open(path.c_str(), O_RDONLY | flags);
+        if (file.fd < 0) {
+            throw FileException("Cannot open " + path + ": " + std::strerror(errno));
+        }
+    }
+
+    static uint64_t file_size(const Descriptor& file, const std::string& path) {
+        struct stat info;
+        if (::fstat(file.fd, &info) != 0) {
+            throw FileException("Cannot stat " + path + ": " + std::strerror(errno));
+        }
+        return static_cast<uint64_t>(info.st_size);
+    }
+
+    // Reads exactly length bytes unless the file ends first
+    static size_t read_at(const Descriptor& file, const std::string& path,
+                          uint8_t* data, size_t length, uint64_t offset) {
+        size_t done = 0;
+        while (done < length) {
+            ssize_t n = ::pread(file.fd, data + done, length - done, static_cast<off_t>(offset + done));
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n < 0) {
+                throw FileException("Cannot read " + path + ": " + std::strerror(errno));
+            }
+            if (n == 0) {
+                break;
+            }
+            done += static_cast<size_t>(n);
+        }
+        return done;
+    }
+
+    void read_blocking(const std::string& path, HashStream& stream) {
+        Descriptor file;
+        open_file(file, path, 0);
+#if defined(POSIX_FADV_SEQUENTIAL)
+        ::posix_fadvise(file.fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+        for (uint64_t offset = 0;; offset += options_.chunk_size) {
+            size_t n = read_at(file, path, buffers_.data(), options_.chunk_size, offset);
+            stream.update(std::span<const uint8_t>(buffers_.data(), n));
+            if (n < options_.chunk_size) {
+                return;
+            }
+        }
+    }
+#else
+    void read_blocking(const std::string& path, HashStream& stream) {
+        std::ifstream in(path, std::ios::binary);
+        if (!in) {
+            throw FileException("Cannot open " + path);
+        }
+        char* data = reinterpret_cast<char*>(buffers_.data());
+        while (in.read(data, static_cast<std::streamsize>(options_.chunk_size)) || in.gcount() > 0) {
+            stream.update(std::span<const uint8_t>(buffers_.data(), static_cast<size_t>(in.gcount())));
+        }
+        if (in.bad()) {
+            throw FileException("Cannot read " + path);
+        }
+    }
+#endif
+
+#if defined(HOLOHASH_HAVE_IO_URING)
+    void init_ring() {
+        auto ring = std::make_unique<platform::IoUring>();
+        if (!ring->init(options_.queue_depth)) {
+            return;
+        }
+        std::vector<iovec> iovecs(options_.queue_depth);
+        for (unsigned i = 0; i < options_.queue_depth; ++i) {
+            iovecs[i] = {buffer(i), options_.chunk_size};
+        }
+        if (ring->register_buffers(iovecs.data(), options_.queue_depth)) {
+            ring_ = std::move(ring);
+        }
+    }
+
+    void read_ring(const std::string& path, HashStream& stream) {
+        Descriptor file;
+        if (options_.direct) {
+            file.fd = ::open(path.c_str(), O_RDONLY | O_DIRECT);
+        }
+        if (file.fd < 0) {
+            open_file(file, path, 0);
+        }
+        const uint64_t size = file_size(file, path);
+        const uint64_t chunks = (size + options_.chunk_size - 1) / options_.chunk_size;
+
+        // Completions never outlive the call: on any error the reads still
+        // in flight are reaped before the buffers can be reused, or the ring
+        // is dropped if they cannot be
+        uint64_t submitted = 0;
+        uint64_t in_flight = 0;
+        auto submit = [&] {
+            const uint64_t chunk = submitted;
+            ready_[chunk % options_.queue_depth] = false;
+            auto queue = [&] {
+                return ring_->read_fixed(file.fd, buffer(chunk), static_cast<unsigned>(options_.chunk_size),
+                                         chunk * options_.chunk_size,
+                                         static_cast<uint16_t>(chunk % options_.queue_depth), chunk);
+            };
+            // A full submission queue is handed to the kernel once before
+            // giving up; a read that was never queued must not be waited for
+            if (!queue() && !(ring_->submit_and_wait(0) && queue())) {
+                throw FileException("Cannot queue a read of " + path);
+            }
+            ++submitted;
+            ++in_flight;
+        };
+
+        try {
+            while (submitted < chunks && submitted < options_.queue_depth) {
+                submit();
+            }
+            for (uint64_t hashed = 0; hashed < chunks;) {
+                const size_t slot = hashed % options_.queue_depth;
+                if (!ready_[slot]) {
+                    if (!ring_->submit_and_wait(1)) {
+                        throw FileException("Cannot read " + path + ": " + std::strerror(errno));
+                    }
+                    reap(path, size, in_flight);
+                    continue;
+                }
+                stream.update(std::span<const uint8_t>(buffer(hashed), lengths_[slot]));
+                ++hashed;
+                if (submitted < chunks) {
+                    submit();
+                }
+            }
+        } catch (...) {
+            while (in_flight > 0 && ring_->submit_and_wait(1)) {
+                uint64_t chunk;
+                int32_t result;
+                while (ring_->pop(chunk, result)) {
+                    --in_flight;
+                }
+            }
+            if (in_flight > 0) {
+                // The ring can no longer be waited on, so later hashes fall
+                // back to pread. Closing it cancels the outstanding reads;
+                // they target the old buffers, which their registration keeps
+                // pinned, so pread gets fresh ones.
+                ring_.reset();
+                buffers_ = platform::PageBuffer(options_.chunk_size * options_.queue_depth, false);
+            }
+            throw;
+        }
+    }
+
+    // Marks completed chunks ready. Short reads, which only happen near a
+    // concurrent truncation or on unusual file systems, are finished with
+    // a buffered pread.
+    void reap(const std::string& path, uint64_t size, uint64_t& in_flight) {
+        uint64_t chunk;
+        int32_t result;
+        while (ring_->pop(chunk, result)) {
+            --in_flight;
+            if (result < 0) {
+                throw FileException("Cannot read " + path + ": " + std::strerror(-result));
+            }
+            const uint64_t offset = chunk * options_.chunk_size;
+            const size_t expected = static_cast<size_t>(std::min<uint64_t>(options_.chunk_size, size - offset));
+            size_t got = static_cast<size_t>(result);
+            if (got < expected) {
+                Descriptor buffered;
+                open_file(buffered, path, 0);
+                got += read_at(buffered, path, buffer(chunk) + got, expected - got, offset + got);
+                if (got < expected) {
+                    throw FileException("Cannot read " + path + ": file shrank while hashing");
+                }
+            }
+            lengths_[chunk % options_.queue_depth] = std::min(got, expected);
+            ready_[chunk % options_.queue_depth] = true;
+        }
+    }
+#endif
+};
+
+// A fixed set of FileHashers, each driven by a thread of its own, that
+// hash queued files in the background. Rings and buffers are created once
+// per hasher, so memory and io_uring instances stay bounded however many
+// hashes are pending. Queued files are still hashed on destruction.
+class FileHashPool {
+public:
+    explicit FileHashPool(size_t hashers = 1, const FileHashOptions& options = {}) {
+        hashers = std::max<size_t>(hashers, 1);
+        hashers_.reserve(hashers);
+        for (size_t i = 0; i < hashers; ++i) {
+            hashers_.push_back(std::make_unique<FileHasher>(options));
+        }
+        workers_.reserve(hashers);
+        for (size_t i = 0; i < hashers; ++i) {
+            workers_.emplace_back([this, hasher = hashers_[i].get()] { run(*hasher); });
+        }
+    }
+
+    FileHashPool(const FileHashPool&) = delete;
+    FileHashPool& operator=(const FileHashPool&) = delete;
+
+    ~FileHashPool() {
+        {
+            std::lock_guard lock(mutex_);
+            stop_ = true;
+        }
+        wake_.notify_all();
+        for (auto& worker : workers_) {
+            worker.join();
+        }
+    }
+
+    // Queues path; the future carries the digest or the FileException
+    std::future<Hash> submit(std::string path, SessionParams params) {
+        Task task([path = std::move(path), params = std::move(params)](FileHasher& hasher) {
+            return hasher.hash(path, params);
+        });
+        auto result = task.get_future();
+        {
+            std::lock_guard lock(mutex_);
+            tasks_.push_back(std::move(task));
+        }
+        wake_.notify_one();
+        return result;
+    }
+
+    size_t size() const noexcept { return hashers_.size(); }
+
+    // Process-wide pool with default options and up to four hashers,
+    // started on first use
+    static FileHashPool& shared() {
+        static FileHashPool pool(std::clamp<size_t>(std::thread::hardware_concurrency(), 1, 4));
+        return pool;
+    }
+
+private:
+    using Task = std::packaged_task<Hash(FileHasher&)>;
+
+    std::vector<std::unique_ptr<FileHasher>> hashers_;
+    std::vector<std::thread> workers_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::deque<Task> tasks_;
+    bool stop_ = false;
+
+    void run(FileHasher& hasher) {
+        for (;;) {
+            Task task;
+            {
+                std::unique_lock lock(mutex_);
+                wake_.wait(lock, [this] { return stop_ || !tasks_.empty(); });
+                if (tasks_.empty()) {
+                    return;
+                }
+                task = std::move(tasks_.front());
+                tasks_.pop_front();
+            }
+            task(hasher);
+        }
+    }
+};
+
+inline std::future<Hash> FileHasher::hash_async(std::string path, SessionParams params) {
+    return FileHashPool::shared().submit(std::move(path), std::move(params));
+}
+
+} // namespace holohash
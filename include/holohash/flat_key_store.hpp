@@ -0,0 +1,316 @@
+#pragma once
+#include "types.hpp"
+#include "generator.hpp"
+#include "platform.hpp"
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <array>
+#include <bit>
+#include <limits>
+#include <type_traits>
+#include <utility>
+
+namespace holohash {
+
+// Control-byte groups of a FlatKeyStore. A control byte is 0x80 for an
+// empty slot, 0xFE for a deleted one and otherwise holds the top seven
+// bits of the slot's key hash, so one 16-byte compare narrows a group of
+// slots down to the few whose keys are worth reading.
+namespace flat_group {
+
+constexpr size_t width = 16;
+constexpr uint8_t empty = 0x80;
+constexpr uint8_t deleted = 0xFE;
+
+// Bit i set where ctrl[i] == tag
+inline uint32_t match(const uint8_t* ctrl, uint8_t tag) noexcept {
+#if defined(HOLOHASH_ARCH_X64)
+    __m128i group = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl));
+    return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8(static_cast<char>(tag)))));
+#else
+    uint32_t mask = 0;
+    for (size_t i = 0; i < width; ++i) {
+        mask |= static_cast<uint32_t>(ctrl[i] == tag) << i;
+    }
+    return mask;
+#endif
+}
+
+inline uint32_t match_empty(const uint8_t* ctrl) noexcept {
+    return match(ctrl, empty);
+}
+
+// Empty or deleted: both have the high bit set, live tags never do
+inline uint32_t match_free(const uint8_t* ctrl) noexcept {
+#if defined(HOLOHASH_ARCH_X64)
+    return static_cast<uint32_t>(_mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl))));
+#else
+    uint32_t mask = 0;
+    for (size_t i = 0; i < width; ++i) {
+        mask |= static_cast<uint32_t>(ctrl[i] >> 7) << i;
+    }
+    return mask;
+#endif
+}
+
+// Keys are uniformly distributed, so their bits are the hash. The leading
+// word already picks ConcurrentKeychain shards; the table uses the next one
+// so keys that share a shard still spread over the whole table.
+constexpr uint64_t key_hash(const uint8_t* key) noexcept {
+    return detail::load_le64(key + 8);
+}
+
+constexpr uint8_t key_tag(uint64_t hash) noexcept {
+    return static_cast<uint8_t>(hash >> 57);
+}
+
+// Slot of key in a table laid out as capacity control bytes plus a parallel
+// array of 32-byte keys, or capacity if absent. Groups are probed in
+// triangular order, which visits every group of a power-of-two table.
+inline size_t find(const uint8_t* ctrl, const uint8_t* keys, size_t capacity, const uint8_t* key) noexcept {
+    const uint64_t hash = key_hash(key);
+    const uint8_t tag = key_tag(hash);
+    const size_t group_mask = capacity / width - 1;
+    size_t group = hash & group_mask;
+
+    for (size_t step = 1; ; ++step) {
+        const uint8_t* group_ctrl = ctrl + group * width;
+        for (uint32_t mask = match(group_ctrl, tag); mask != 0; mask &= mask - 1) {
+            size_t slot = group * width + static_cast<size_t>(std::countr_zero(mask));
+            if (std::memcmp(keys + slot * 32, key, 32) == 0) {
+                return slot;
+            }
+        }
+        if (match_empty(group_ctrl) != 0 || step > group_mask) {
+            return capacity;
+        }
+        group = (group + step) & group_mask;
+    }
+}
+
+} // namespace flat_group
+
+// Open-addressing hash table from Key to a small, trivially copyable
+// Record. Control bytes, keys and records live in three parallel arrays
+// inside one PageBuffer slab, so a lookup touches one group of control
+// bytes and, on a tag match, one key; there are no per-entry allocations.
+// Live keys plus tombstones stay at most 7/8 of the slots; past that the
+// table doubles, or is rebuilt at the same size if fewer than 25/32 of the
+// slots hold live keys.
+//
+// Slots are stable until the table rehashes, which only happens inside
+// insert(). Records are not constructed or destroyed, only copied in.
+template<typename Record>
+class FlatKeyStore {
+    static_assert(std::is_trivially_copyable_v<Record>, "Records are copied bytewise");
+
+public:
+    static constexpr size_t key_size = 32;
+    static constexpr size_t min_capacity = flat_group::width;
+    static constexpr size_t npos = std::numeric_limits<size_t>::max();
+
+    explicit FlatKeyStore(size_t expected_keys = 0, bool huge_pages = false)
+        : huge_pages_(huge_pages) {
+        allocate(capacity_for(expected_keys));
+    }
+
+    FlatKeyStore(FlatKeyStore&&) noexcept = default;
+    FlatKeyStore& operator=(FlatKeyStore&&) noexcept = default;
+
+    // Smallest table holding keys entries within the load limit
+    static size_t capacity_for(size_t keys) noexcept {
+        size_t capacity = min_capacity;
+        while (max_load(capacity) < keys) {
+            capacity *= 2;
+        }
+        return capacity;
+    }
+
+    static constexpr size_t max_load(size_t capacity) noexcept {
+        return capacity - capacity / 8;
+    }
+
+    // Slab size for a table of the given capacity
+    static constexpr size_t bytes_for(size_t capacity) noexcept {
+        return records_offset(capacity) + capacity * sizeof(Record);
+    }
+
+    size_t size() const noexcept { return size_; }
+    bool empty() const noexcept { return size_ == 0; }
+    size_t capacity() const noexcept { return capacity_; }
+    size_t memory_bytes() const noexcept { return slab_.size(); }
+    bool huge_pages() const noexcept { return slab_.huge(); }
+
+    size_t find(const Key& key) const noexcept {
+        size_t slot = flat_group::find(ctrl(), keys(), capacity_, key.get().data());
+        return slot == capacity_ ? npos : slot;
+    }
+
+    Record* find_record(const Key& key) noexcept {
+        size_t slot = find(key);
+        return slot == npos ? nullptr : &record(slot);
+    }
+
+    const Record* find_record(const Key& key) const noexcept {
+        size_t slot = find(key);
+        return slot == npos ? nullptr : &record(slot);
+    }
+
+    // Inserts key with record unless it is already present. Returns the
+    // key's slot and whether it was inserted; an existing record is left
+    // untouched.
+    std::pair<size_t, bool> insert(const Key& key, const Record& value) {
+        const uint8_t* key_bytes = key.get().data();
+        size_t slot = flat_group::find(ctrl(), keys(), capacity_, key_bytes);
+        if (slot != capacity_) {
+            return {slot, false};
+        }
+
+        if (size_ + deleted_ + 1 > max_load(capacity_)) {
+            // Tombstones alone can fill the table; reclaim them in place
+            // unless live keys need the room
+            rehash(size_ + 1 > capacity_ * 25 / 32 ? capacity_ * 2 : capacity_);
+        }
+
+        slot = free_slot(flat_group::key_hash(key_bytes));
+        if (ctrl()[slot] == flat_group::deleted) {
+            --deleted_;
+        }
+        place(slot, key_bytes, value);
+        return {slot, true};
+    }
+
+    bool erase(const Key& key) noexcept {
+        size_t slot = find(key);
+        if (slot == npos) {
+            return false;
+        }
+        erase_slot(slot);
+        return true;
+    }
+
+    // A probe stops at the first group with an empty slot, so a slot in such
+    // a group can go straight back to empty; otherwise it has to stay a
+    // tombstone to keep later keys of the probe chain reachable
+    void erase_slot(size_t slot) noexcept {
+        uint8_t* group_ctrl = ctrl() + (slot & ~(flat_group::width - 1));
+        if (flat_group::match_empty(group_ctrl) != 0) {
+            ctrl()[slot] = flat_group::empty;
+        } else {
+            ctrl()[slot] = flat_group::deleted;
+            ++deleted_;
+        }
+        --size_;
+    }
+
+    void reserve(size_t keys) {
+        if (keys > max_load(capacity_)) {
+            rehash(capacity_for(keys));
+        }
+    }
+
+    void clear() noexcept {
+        std::memset(ctrl(), flat_group::empty, capacity_);
+        size_ = 0;
+        deleted_ = 0;
+    }
+
+    // Slot access for sweeps over the whole table
+    bool occupied(size_t slot) const noexcept { return (ctrl()[slot] & 0x80) == 0; }
+    const uint8_t* key_at(size_t slot) const noexcept { return keys() + slot * key_size; }
+    Record& record(size_t slot) noexcept { return mutable_records()[slot]; }
+    const Record& record(size_t slot) const noexcept { return records()[slot]; }
+
+    // The slab holds control bytes at offset 0, then keys at keys_offset()
+    // and records at records_offset(), bytes_for(capacity()) bytes in all.
+    // Key snapshots are this image written out as is.
+    const uint8_t* data() const noexcept { return slab_.data(); }
+    const Record* records() const noexcept {
+        return reinterpret_cast<const Record*>(slab_.data() + records_offset(capacity_));
+    }
+
+    static constexpr size_t keys_offset(size_t capacity) noexcept { return align_up(capacity); }
+    static constexpr size_t records_offset(size_t capacity) noexcept {
+        return align_up(keys_offset(capacity) + capacity * key_size);
+    }
+
+    // Deep copy; one memcpy of the slab
+    FlatKeyStore clone() const {
+        FlatKeyStore copy(0, huge_pages_);
+        copy.slab_ = platform::PageBuffer(bytes_for(capacity_), huge_pages_);
+        std::memcpy(copy.slab_.data(), slab_.data(), bytes_for(capacity_));
+        copy.capacity_ = capacity_;
+        copy.size_ = size_;
+        copy.deleted_ = deleted_;
+        return copy;
+    }
+
+private:
+    platform::PageBuffer slab_;
+    size_t capacity_ = 0;
+    size_t size_ = 0;
+    size_t deleted_ = 0;
+    bool huge_pages_ = false;
+
+    static constexpr size_t align_up(size_t n) noexcept {
+        return (n + platform::get_cache_line_size() - 1) & ~(platform::get_cache_line_size() - 1);
+    }
+
+    uint8_t* ctrl() const noexcept { return slab_.data(); }
+    uint8_t* keys() const noexcept { return slab_.data() + keys_offset(capacity_); }
+    Record* mutable_records() noexcept {
+        return reinterpret_cast<Record*>(slab_.data() + records_offset(capacity_));
+    }
+
+    void allocate(size_t capacity) {
+        slab_ = platform::PageBuffer(bytes_for(capacity), huge_pages_);
+        capacity_ = capacity;
+        std::memset(ctrl(), flat_group::empty, capacity_);
+    }
+
+    size_t free_slot(uint64_t hash) const noexcept {
+        const size_t group_mask = capacity_ / flat_group::width - 1;
+        size_t group = hash & group_mask;
+        for (size_t step = 1; ; ++step) {
+            uint32_t mask = flat_group::match_free(ctrl() + group * flat_group::width);
+            if (mask != 0) {
+                return group * flat_group::width + static_cast<size_t>(std::countr_zero(mask));
+            }
+            group = (group + step) & group_mask;
+        }
+    }
+
+    void place(size_t slot, const uint8_t* key_bytes, const Record& value) noexcept {
+        ctrl()[slot] = flat_group::key_tag(flat_group::key_hash(key_bytes));
+        std::memcpy(keys() + slot * key_size, key_bytes, key_size);
+        std::memcpy(static_cast<void*>(mutable_records() + slot), &value, sizeof(Record));
+        ++size_;
+    }
+
+    void rehash(size_t capacity) {
+        FlatKeyStore old(std::move(*this));
+        allocate(capacity);
+        size_ = 0;
+        deleted_ = 0;
+        for (size_t slot = 0; slot < old.capacity_; ++slot) {
+            if (old.occupied(slot)) {
+                const uint8_t* key_bytes = old.key_at(slot);
+                place(free_slot(flat_group::key_hash(key_bytes)), key_bytes, old.record(slot));
+            }
+        }
+    }
+};
+
+// Per-key record of FlatKeychain, and of key snapshots on disk
+struct KeyRecord {
+    std::array<uint64_t, 2> context;    // FlatKeychain::context_digest()
+    int64_t expires_at;                 // nanoseconds since the epoch
+    uint8_t referenced;                 // CLOCK second-chance bit
+    uint8_t revoked;                    // never validates; older snapshot files may hold such records
+    uint8_t reserved[6];
+};
+
+static_assert(sizeof(KeyRecord) == 32);
+
+} // namespace holohash
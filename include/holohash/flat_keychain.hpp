@@ -0,0 +1,409 @@
+#pragma once
+#include "keychain.hpp"
+#include "flat_key_store.hpp"
+#include "key_snapshot.hpp"
+#include "key_log.hpp"
+#include <array>
+#include <future>
+#include <memory>
+#include <bit>
+#include <string>
+#include <chrono>
+#include <limits>
+#include <vector>
+
+namespace holohash {
+
+// Keychain variant for very large key counts. Instead of a map node with
+// full copies of SessionParams and SystemState, each key takes one slot of
+// a FlatKeyStore: the key itself plus a 32-byte record holding a 128-bit
+// digest of its context and its expiry time. validate_key() compares the
+// digest of the presented context against the stored one.
+//
+// Budgets and TTL follow KeychainOptions. Bounded tables are sized once up
+// front and never rehash; the CLOCK hand walks the slots and reclaims
+// expired keys it passes. Unbounded tables grow by doubling, and their
+// expired keys are only reclaimed by expire(), which sweeps the table.
+//
+// For warm restarts the table can be saved as a KeySnapshot and the file
+// attached to a new keychain with load_snapshot(). Keys not in the live
+// table are then looked up in the mapped file in place. Changes made since
+// the last snapshot can be recorded in a KeyLog and replayed on startup.
+class FlatKeychain {
+public:
+    explicit FlatKeychain(
+        AlgorithmVersion version = AlgorithmVersion::v1,
+        NonceMode nonce_mode = NonceMode::recursive
+    ) : FlatKeychain(KeychainOptions{version, nonce_mode}) {}
+
+    explicit FlatKeychain(const KeychainOptions& options)
+        : options_(options),
+          deriver_(options.version, options.nonce_mode),
+          limit_(key_limit(options)),
+          store_(limit_ + limit_ / 6, options.huge_pages) {}
+
+    FlatKeychain(FlatKeychain&&) = default;
+    FlatKeychain& operator=(FlatKeychain&&) = default;
+
+    // Nothing is allocated per key; packed contexts make the whole call
+    // allocation-free
+    Key generate_key(
+        std::span<const uint8_t> input,
+        const SessionView& params,
+        const StateView& state
+    ) {
+        metrics::ScopedTimer timer(metrics::Op::generate_key, input.size());
+        auto key = deriver_.derive_key(input, params, state);
+        store_key(key, params, state);
+        return key;
+    }
+
+    // As generate_key(), but failures are returned instead of thrown. With a
+    // bounded table and no log attached, nothing can fail but empty input.
+    HashResult<Key> try_generate_key(
+        std::span<const uint8_t> input,
+        const SessionView& params,
+        const StateView& state
+    ) noexcept {
+        if (input.empty()) {
+            return ErrorCode::empty_input;
+        }
+        try {
+            return generate_key(input, params, state);
+        } catch (const std::bad_alloc&) {
+            return ErrorCode::out_of_memory;
+        } catch (...) {
+            return ErrorCode::key_store;
+        }
+    }
+
+    Key generate_key(const Keychain::KeyStream& stream) {
+        metrics::ScopedTimer timer(metrics::Op::generate_key, stream.size());
+        auto key = Keychain::derive_key(stream);
+        store_key(key, stream.params(), stream.state());
+        return key;
+    }
+
+    bool validate_key(
+        const Key& key,
+        const SessionView& params,
+        const StateView& state
+    ) const {
+        metrics::ScopedTimer timer(metrics::Op::validate_key);
+        bool valid;
+        if (Record* record = store_.find_record(key)) {
+            record->referenced = 1;
+            valid = !record->revoked && live(*record) && record->context == context_digest(params, state);
+        } else {
+            const size_t slot = snapshot_ ? snapshot_->find_slot(key) : FlatKeyStore<Record>::npos;
+            if (slot == FlatKeyStore<Record>::npos) {
+                valid = false;
+            } else {
+                const Record& restored = snapshot_->record(slot);
+                valid = !restored.revoked && !masked_[slot] &&
+                        live(restored) && restored.context == context_digest(params, state);
+            }
+        }
+        timer.fail(!valid);
+        return valid;
+    }
+
+    // Attaches a snapshot written by save_snapshot(). Opening it only maps
+    // the file; the live table shadows keys regenerated since.
+    void load_snapshot(const std::string& path) {
+        auto snapshot = std::make_shared<const KeySnapshot>(path);
+        if (snapshot->version() != options_.version || snapshot->nonce_mode() != options_.nonce_mode) {
+            throw KeychainException("Key snapshot " + path + " was written with different key settings");
+        }
+        masked_.assign(snapshot->capacity(), false);
+        snapshot_ = std::move(snapshot);
+    }
+
+    // Writes the live keys, plus the unexpired keys of an attached snapshot,
+    // to path
+    void save_snapshot(const std::string& path) const {
+        if (!snapshot_) {
+            KeySnapshot::write(path, store_, options_.version, options_.nonce_mode);
+            return;
+        }
+        write_snapshot(path, store_.clone(), snapshot_, masked_, options_);
+    }
+
+    // As save_snapshot(), but only the copy of the table happens on the
+    // calling thread; merging and writing run on a background thread
+    std::future<void> save_snapshot_async(std::string path) const {
+        return std::async(std::launch::async,
+            [path = std::move(path), store = store_.clone(), snapshot = snapshot_, masked = masked_,
+             options = options_]() mutable {
+                write_snapshot(path, std::move(store), snapshot, masked, options);
+            });
+    }
+
+    const KeySnapshot* snapshot() const noexcept { return snapshot_.get(); }
+
+    // Invalidates key before its TTL. A copy in an attached snapshot is
+    // masked so it cannot validate again. False if the key is unknown.
+    bool revoke_key(const Key& key) {
+        if (!remove_key(key)) {
+            return false;
+        }
+        if (log_) {
+            log_->append(KeyLog::Op::revoke, key.get().data(), Record{});
+        }
+        return true;
+    }
+
+    // Records every insertion, eviction and revocation from now on; pass
+    // nullptr to detach. Expiry is not logged, replay() drops expired keys.
+    void attach_log(std::shared_ptr<KeyLog> log) noexcept { log_ = std::move(log); }
+    KeyLog* log() const noexcept { return log_.get(); }
+
+    // Applies the log at path to the live table, e.g. after load_snapshot(),
+    // and returns the number of entries applied. Nothing is logged while
+    // replaying.
+    uint64_t replay_log(const std::string& path) {
+        auto log = std::exchange(log_, nullptr);
+        uint64_t count = 0;
+        try {
+            count = KeyLog::replay(path, [this](const KeyLog::Entry& entry) {
+                Key key{entry.key};
+                if (entry.op == KeyLog::Op::insert) {
+                    Record record = entry.record;
+                    record.referenced = 0;
+                    if (!expires() || now_ns() < record.expires_at) {
+                        put(key, record);
+                    }
+                } else if (entry.op == KeyLog::Op::revoke) {
+                    remove_key(key);
+                } else {
+                    store_.erase(key);
+                    hide_restored(key);
+                }
+            });
+        } catch (...) {
+            log_ = std::move(log);
+            throw;
+        }
+        log_ = std::move(log);
+        return count;
+    }
+
+    // Drops every key whose TTL has passed by now, in one pass over the table
+    void expire(std::chrono::system_clock::time_point now = std::chrono::system_clock::now()) {
+        if (!expires()) {
+            return;
+        }
+        const int64_t now_count = to_ns(now);
+        for (size_t slot = 0; slot < store_.capacity(); ++slot) {
+            if (store_.occupied(slot) && now_count >= store_.record(slot).expires_at) {
+                ++expirations_;
+                drop_slot(slot);
+            }
+        }
+    }
+
+    KeychainStats stats() const noexcept {
+        return KeychainStats{store_.size(), store_.memory_bytes(), evictions_, expirations_};
+    }
+
+    size_t size() const noexcept { return store_.size(); }
+    size_t capacity() const noexcept { return store_.capacity(); }
+    bool huge_pages() const noexcept { return store_.huge_pages(); }
+    const KeychainOptions& options() const noexcept { return options_; }
+    AlgorithmVersion version() const noexcept { return options_.version; }
+    NonceMode nonce_mode() const noexcept { return options_.nonce_mode; }
+
+    // 128-bit digest of everything validate_key() compares
+    static std::array<uint64_t, 2> context_digest(const SessionView& params, const StateView& state) noexcept {
+        std::array<uint64_t, 2> digest{0x486F6C6F4B657931ULL, 0x486F6C6F4B657932ULL};
+        auto bytes = [&digest](std::span<const uint8_t> data) {
+            digest[0] = digest64(data, digest[0]);
+            digest[1] = digest64(data, digest[1] ^ CounterGenerator::increment);
+        };
+        auto word = [&digest](uint64_t value) {
+            digest[0] = detail::mix64(digest[0] ^ value) + CounterGenerator::increment;
+            digest[1] = detail::mix64(digest[1] + value) ^ CounterGenerator::increment;
+        };
+
+        bytes(params.source_ip);
+        bytes(params.dest_ip);
+        word(static_cast<uint64_t>(to_ns(params.timestamp)));
+        bytes(params.metadata);
+
+        bytes(state.content_hash);
+        // -0.0 == 0.0, so both have to digest alike
+        word(state.cpu_load == 0.0 ? 0 : std::bit_cast<uint64_t>(state.cpu_load));
+        word(state.memory_usage);
+        word(static_cast<uint64_t>(to_ns(state.timestamp)));
+        bytes(state.previous_nonce);
+        return digest;
+    }
+
+private:
+    using Record = KeyRecord;
+
+    static constexpr int64_t never = std::numeric_limits<int64_t>::max();
+
+    KeychainOptions options_;
+    Keychain deriver_;  // key derivation settings only, never stores
+    size_t limit_;
+    // validate_key() sets CLOCK reference bits
+    mutable FlatKeyStore<Record> store_;
+    std::shared_ptr<const KeySnapshot> snapshot_;
+    // One bit per slot of the attached snapshot, set for keys that must not
+    // validate from it: revoked ones, and ones whose live copy was evicted
+    // or expired. Sized once on attach, so masking neither allocates nor
+    // counts against the key budget.
+    std::vector<bool> masked_;
+    std::shared_ptr<KeyLog> log_;
+    size_t clock_hand_ = 0;
+    uint64_t evictions_ = 0;
+    uint64_t expirations_ = 0;
+
+    bool expires() const noexcept { return options_.ttl.count() > 0; }
+
+    static int64_t to_ns(std::chrono::system_clock::time_point tp) noexcept {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(tp.time_since_epoch()).count();
+    }
+
+    static int64_t now_ns() noexcept { return to_ns(std::chrono::system_clock::now()); }
+
+    bool live(const Record& record) const noexcept {
+        return !expires() || now_ns() < record.expires_at;
+    }
+
+    static void write_snapshot(
+        const std::string& path,
+        FlatKeyStore<Record> store,
+        const std::shared_ptr<const KeySnapshot>& snapshot,
+        const std::vector<bool>& masked,
+        const KeychainOptions& options
+    ) {
+        if (snapshot) {
+            const bool expires = options.ttl.count() > 0;
+            const int64_t now = now_ns();
+            Key key{{}};
+            for (size_t slot = 0; slot < snapshot->capacity(); ++slot) {
+                if (!snapshot->occupied(slot)) {
+                    continue;
+                }
+                const Record& record = snapshot->record(slot);
+                if (masked[slot] || record.revoked || (expires && now >= record.expires_at)) {
+                    continue;
+                }
+                std::memcpy(key.get().data(), snapshot->key_at(slot), key.get().size());
+                // Live records win over restored ones
+                store.insert(key, record);
+            }
+        }
+        KeySnapshot::write(path, store, options.version, options.nonce_mode);
+    }
+
+    // Most keys a bounded table may hold, or 0 if unbounded. The table is
+    // sized so the limit is at most 3/4 of its slots (hence limit + limit/6
+    // at the 7/8 load factor), so erasures rarely leave tombstones behind.
+    static size_t key_limit(const KeychainOptions& options) noexcept {
+        if (options.max_keys == 0 && options.max_bytes == 0) {
+            return 0;
+        }
+        size_t limit = options.max_keys != 0 ? options.max_keys : std::numeric_limits<size_t>::max();
+        if (options.max_bytes != 0) {
+            size_t capacity = FlatKeyStore<Record>::min_capacity;
+            while (FlatKeyStore<Record>::bytes_for(capacity * 2) <= options.max_bytes) {
+                capacity *= 2;
+            }
+            limit = std::min(limit, capacity - capacity / 4);
+        }
+        return limit;
+    }
+
+    void store_key(const Key& key, const SessionView& params, const StateView& state) {
+        Record record{context_digest(params, state), never, 0, 0, {}};
+        if (expires()) {
+            const int64_t now = now_ns();
+            record.expires_at = to_ns(params.timestamp + options_.ttl);
+            if (now >= record.expires_at) {
+                ++expirations_;
+                return;
+            }
+        }
+
+        put(key, record);
+        if (log_) {
+            log_->append(KeyLog::Op::insert, key.get().data(), record);
+        }
+    }
+
+    void put(const Key& key, const Record& record) {
+        if (Record* existing = store_.find_record(key)) {
+            // Regenerated key: refresh its context in place
+            *existing = record;
+            return;
+        }
+
+        while (limit_ != 0 && store_.size() >= limit_) {
+            evict_one();
+        }
+        store_.insert(key, record);
+    }
+
+    bool remove_key(const Key& key) {
+        const size_t slot = store_.find(key);
+        bool removed = slot != FlatKeyStore<Record>::npos;
+        if (removed) {
+            store_.erase_slot(slot);
+        }
+        return hide_restored(key) || removed;
+    }
+
+    // Stops an attached snapshot's copy of key from validating; true if
+    // there was a copy that could still validate
+    bool hide_restored(const Key& key) {
+        const size_t slot = snapshot_ ? snapshot_->find_slot(key) : FlatKeyStore<Record>::npos;
+        if (slot == FlatKeyStore<Record>::npos || snapshot_->record(slot).revoked || masked_[slot]) {
+            return false;
+        }
+        masked_[slot] = true;
+        return true;
+    }
+
+    // Erases a live key; a snapshot copy must not take its place
+    void drop_slot(size_t slot) {
+        if (snapshot_) {
+            Key key{{}};
+            std::memcpy(key.get().data(), store_.key_at(slot), key.get().size());
+            hide_restored(key);
+        }
+        store_.erase_slot(slot);
+    }
+
+    // CLOCK over the slot array: expired keys under the hand go first, then
+    // the first key not validated since the hand last passed it
+    void evict_one() {
+        const int64_t now = expires() ? now_ns() : std::numeric_limits<int64_t>::min();
+        const size_t mask = store_.capacity() - 1;
+        for (;; clock_hand_ = (clock_hand_ + 1) & mask) {
+            if (!store_.occupied(clock_hand_)) {
+                continue;
+            }
+            Record& record = store_.record(clock_hand_);
+            if (now >= record.expires_at) {
+                ++expirations_;
+                break;
+            }
+            if (record.referenced) {
+                record.referenced = 0;
+                continue;
+            }
+            ++evictions_;
+            if (log_) {
+                log_->append(KeyLog::Op::evict, store_.key_at(clock_hand_), record);
+            }
+            break;
+        }
+        drop_slot(clock_hand_);
+        clock_hand_ = (clock_hand_ + 1) & mask;
+    }
+};
+
+} // namespace holohash
@@ -0,0 +1,181 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <array>
+#include <span>
+
+namespace holohash {
+
+// Algorithm revisions. v1 is the original transform driven by
+// std::mt19937 engines; v2 replaces them with the counter-based generator
+// below and has a fixed, platform-independent output specification.
+enum class AlgorithmVersion : uint8_t {
+    v1 = 1,
+    v2 = 2
+};
+
+namespace detail {
+
+// SplitMix64 finalizer
+constexpr uint64_t mix64(uint64_t z) noexcept {
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+// High 64 bits of a 64x64-bit product, written out in 32-bit halves so it
+// is portable and usable in constant expressions
+constexpr uint64_t mul_hi64(uint64_t a, uint64_t b) noexcept {
+    const uint64_t a_lo = a & 0xFFFFFFFFu, a_hi = a >> 32;
+    const uint64_t b_lo = b & 0xFFFFFFFFu, b_hi = b >> 32;
+
+    const uint64_t lo_lo = a_lo * b_lo;
+    const uint64_t hi_lo = a_hi * b_lo;
+    const uint64_t lo_hi = a_lo * b_hi;
+    const uint64_t hi_hi = a_hi * b_hi;
+
+    const uint64_t cross = (lo_lo >> 32) + (hi_lo & 0xFFFFFFFFu) + lo_hi;
+    return hi_hi + (hi_lo >> 32) + (cross >> 32);
+}
+
+// Little-endian load, independent of host byte order
+constexpr uint64_t load_le64(const uint8_t* p) noexcept {
+    uint64_t v = 0;
+    for (size_t i = 0; i < 8; ++i) {
+        v |= static_cast<uint64_t>(p[i]) << (i * 8);
+    }
+    return v;
+}
+
+// The 64-bit Mersenne Twister exactly as the standard specifies
+// std::mt19937_64, so it produces the same sequence, but usable in
+// constant expressions
+class Mt19937_64 {
+public:
+    constexpr explicit Mt19937_64(uint64_t seed) noexcept {
+        state_[0] = seed;
+        for (size_t i = 1; i < n; ++i) {
+            state_[i] = 6364136223846793005ULL * (state_[i - 1] ^ (state_[i - 1] >> 62)) + i;
+        }
+    }
+
+    constexpr uint64_t operator()() noexcept {
+        if (index_ == n) {
+            twist();
+        }
+        uint64_t y = state_[index_++];
+        y ^= (y >> 29) & 0x5555555555555555ULL;
+        y ^= (y << 17) & 0x71D67FFFEDA60000ULL;
+        y ^= (y << 37) & 0xFFF7EEE000000000ULL;
+        return y ^ (y >> 43);
+    }
+
+private:
+    static constexpr size_t n = 312;
+    static constexpr size_t m = 156;
+    static constexpr uint64_t matrix = 0xB5026F5AA96619E9ULL;
+    static constexpr uint64_t upper = 0xFFFFFFFF80000000ULL;
+    static constexpr uint64_t lower = 0x7FFFFFFFULL;
+
+    std::array<uint64_t, n> state_{};
+    size_t index_ = n;
+
+    static constexpr uint64_t twisted(uint64_t hi, uint64_t lo, uint64_t far) noexcept {
+        const uint64_t x = (hi & upper) | (lo & lower);
+        return far ^ (x >> 1) ^ ((x & 1) ? matrix : 0);
+    }
+
+    constexpr void twist() noexcept {
+        size_t i = 0;
+        for (; i < n - m; ++i) {
+            state_[i] = twisted(state_[i], state_[i + 1], state_[i + m]);
+        }
+        for (; i < n - 1; ++i) {
+            state_[i] = twisted(state_[i], state_[i + 1], state_[i + m - n]);
+        }
+        state_[n - 1] = twisted(state_[n - 1], state_[0], state_[m - 1]);
+        index_ = 0;
+    }
+};
+
+} // namespace detail
+
+// Index generator used by the v1 hash transform: a std::mt19937_64
+// sequence reduced to the requested range with a modulo.
+class Mt19937Generator {
+public:
+    constexpr explicit Mt19937Generator(uint64_t seed) noexcept : rng_(seed) {}
+
+    constexpr explicit Mt19937Generator(const std::array<uint8_t, 16>& seed) noexcept : rng_(fold(seed)) {}
+
+    constexpr size_t operator()(size_t bound) noexcept {
+        return static_cast<size_t>(rng_() % bound);
+    }
+
+    // The engine seed for an IV: its bytes folded into one word, last byte
+    // lowest
+    static constexpr uint64_t fold(const std::array<uint8_t, 16>& seed) noexcept {
+        uint64_t v = 0;
+        for (uint8_t byte : seed) {
+            v = ((v << 8) | (v >> 56)) ^ byte;
+        }
+        return v;
+    }
+
+private:
+    detail::Mt19937_64 rng_;
+};
+
+// Counter-based index generator used by the v2 transforms.
+//
+//   key       = mix64(le64(seed[0..8]) ^ mix64(le64(seed[8..16])))
+//   word(i)   = mix64(key + (i + 1) * 0x9E3779B97F4A7C15)   for i = 0, 1, ...
+//   index(n)  = high 64 bits of word(i) * n                  (0 <= index < n)
+//
+// The state is two 64-bit words, construction is two mixes, and each draw
+// costs one mix and one widening multiply instead of a division.
+class CounterGenerator {
+public:
+    static constexpr uint64_t increment = 0x9E3779B97F4A7C15ULL;
+
+    constexpr explicit CounterGenerator(uint64_t key) noexcept : key_(key) {}
+
+    constexpr explicit CounterGenerator(const std::array<uint8_t, 16>& seed) noexcept
+        : key_(key_for(seed)) {}
+
+    static constexpr uint64_t key_for(const std::array<uint8_t, 16>& seed) noexcept {
+        return detail::mix64(detail::load_le64(seed.data()) ^
+                             detail::mix64(detail::load_le64(seed.data() + 8)));
+    }
+
+    constexpr uint64_t next() noexcept {
+        counter_ += increment;
+        return detail::mix64(key_ + counter_);
+    }
+
+    // Uniform index in [0, bound) by multiply-shift range reduction
+    constexpr size_t operator()(size_t bound) noexcept {
+        return static_cast<size_t>(detail::mul_hi64(next(), bound));
+    }
+
+private:
+    uint64_t key_;
+    uint64_t counter_ = 0;
+};
+
+// Portable 64-bit digest of a byte range, used to seed v2 generators from
+// input contents
+constexpr uint64_t digest64(std::span<const uint8_t> data, uint64_t seed = 0) noexcept {
+    uint64_t h = detail::mix64(seed ^ (data.size() * CounterGenerator::increment));
+    size_t i = 0;
+    for (; i + 8 <= data.size(); i += 8) {
+        h = detail::mix64(h ^ detail::load_le64(data.data() + i)) + CounterGenerator::increment;
+    }
+    uint64_t tail = 0;
+    for (size_t shift = 0; i < data.size(); ++i, shift += 8) {
+        tail |= static_cast<uint64_t>(data[i]) << shift;
+    }
+    return detail::mix64(h ^ tail);
+}
+
+} // namespace holohash
@@ -1,54 +1,267 @@
 #pragma once
 #include "types.hpp"
 #include "exceptions.hpp"
+#include "result.hpp"
 #include "platform.hpp"
+#include "generator.hpp"
+#include "thread_pool.hpp"
+#include "metrics.hpp"
 #include <span>
 #include <array>
+#include <algorithm>
 #include <bit>
-#include <random>
+#include <type_traits>
+#include <vector>
 
 namespace holohash {
 
+template<size_t Bits, size_t Rounds, size_t MixRounds>
+class BasicHolographicHash;
+
+// Everything compute() derives from the session rather than the message:
+// the initialization vector and the index generator seed. Preparing a
+// session once and hashing its messages with compute(input, session) skips
+// that work on every call and gives the same digests as compute(input,
+// params, version). Small and trivially copyable, so it can live inline in
+// per-connection state. A default-constructed PreparedSession is the v1
+// session of empty addresses at the epoch.
+class PreparedSession {
+public:
+    constexpr PreparedSession() = default;
+
+    constexpr AlgorithmVersion version() const noexcept { return version_; }
+    constexpr const std::array<uint8_t, 16>& iv() const noexcept { return iv_; }
+
+    bool operator==(const PreparedSession&) const = default;
+
+private:
+    friend class HolographicHash;
+    template<size_t, size_t, size_t> friend class BasicHolographicHash;
+
+    alignas(16) std::array<uint8_t, 16> iv_{};
+    uint64_t seed_ = 0;     // v1: mt19937_64 seed, v2: CounterGenerator key
+    AlgorithmVersion version_ = AlgorithmVersion::v1;
+};
+
+static_assert(std::is_trivially_copyable_v<PreparedSession>);
+static_assert(sizeof(PreparedSession) == 32);
+
+// Tree mode: the input is split into chunk_size leaves that are hashed
+// independently, then a root hash over the leaf digests binds them together
+// with chunk_size and the input length. Digests depend on chunk_size but not
+// on the pool or its thread count.
+struct TreeParams {
+    size_t chunk_size = size_t{1} << 20;   // multiple of HashStream::block_size
+    ThreadPool* pool = nullptr;             // nullptr uses ThreadPool::shared()
+};
+
 class HolographicHash {
 public:
-    static Hash compute(std::span<const uint8_t> input, const SessionParams& params) {
+    // Both compute() overloads and prepare() are constexpr, so digests of
+    // identifiers known at build time can be computed by the compiler:
+    //
+    //     constexpr auto route = literal_bytes("tenant-42/orders");
+    //     constexpr Hash digest = HolographicHash::compute(route, PreparedSession{});
+    //
+    // Constant evaluation runs the scalar kernels and gives the same digest
+    // as the runtime path for the same version.
+    static constexpr Hash compute(
+        std::span<const uint8_t> input,
+        const SessionView& params,
+        AlgorithmVersion version = AlgorithmVersion::v1
+    ) {
+        return compute(input, prepare(params, version));
+    }
+
+    static constexpr Hash compute(std::span<const uint8_t> input, const PreparedSession& session) {
         if (input.empty()) {
             throw InvalidInputException("Input data cannot be empty");
         }
+        if (std::is_constant_evaluated()) {
+            return digest(input, session);
+        }
+        return compute_unchecked(input, session);
+    }
 
-        std::array<uint8_t, 32> result{};
-        
-        // Initialize with session parameters
-        auto init_vector = initialize_vector(params);
-        
-        // Apply holographic transformation
-        apply_holographic_transform(input, init_vector, result);
-        
-        // Additional mixing rounds for better diffusion
-        for (int round = 0; round < 4; ++round) {
-            mix_round(result);
+    // As compute(), but failures are returned instead of thrown. Neither
+    // variant allocates.
+    static HashResult<Hash> try_compute(
+        std::span<const uint8_t> input,
+        const SessionView& params,
+        AlgorithmVersion version = AlgorithmVersion::v1
+    ) noexcept {
+        if (input.empty()) {
+            return ErrorCode::empty_input;
         }
-        
-        return Hash{result};
+        return compute_unchecked(input, prepare(params, version));
+    }
+
+    static HashResult<Hash> try_compute(std::span<const uint8_t> input, const PreparedSession& session) noexcept {
+        if (input.empty()) {
+            return ErrorCode::empty_input;
+        }
+        return compute_unchecked(input, session);
+    }
+
+    static constexpr PreparedSession prepare(
+        const SessionView& params,
+        AlgorithmVersion version = AlgorithmVersion::v1
+    ) {
+        PreparedSession session;
+        session.iv_ = initialize_vector(params, version);
+        session.seed_ = version == AlgorithmVersion::v1
+            ? Mt19937Generator::fold(session.iv_)
+            : CounterGenerator::key_for(session.iv_);
+        session.version_ = version;
+        return session;
+    }
+
+    // Hashes many independent inputs at once. Inputs are processed in groups
+    // of ByteLanes16::lanes with one hash state per vector lane, producing the
+    // same digests as calling compute() on each input/params pair.
+    static void compute_batch(
+        std::span<const std::span<const uint8_t>> inputs,
+        std::span<const SessionParams> params,
+        std::span<Hash> out,
+        AlgorithmVersion version = AlgorithmVersion::v1
+    ) {
+        compute_batch_impl(inputs, params, out, version);
+    }
+
+    static void compute_batch(
+        std::span<const std::span<const uint8_t>> inputs,
+        std::span<const SessionView> params,
+        std::span<Hash> out,
+        AlgorithmVersion version = AlgorithmVersion::v1
+    ) {
+        compute_batch_impl(inputs, params, out, version);
+    }
+
+    // Hashes a large input on several threads; see TreeParams. Like
+    // HashStream, tree mode always uses the v2 encoding, and its digests
+    // differ from both compute() and HashStream.
+    static Hash compute_tree(
+        std::span<const uint8_t> input,
+        const SessionView& params,
+        const TreeParams& tree = {}
+    );
+
+    // All sessions of one batch must share an algorithm version
+    static void compute_batch(
+        std::span<const std::span<const uint8_t>> inputs,
+        std::span<const PreparedSession> sessions,
+        std::span<Hash> out
+    ) {
+        if (sessions.empty()) {
+            compute_batch_impl(inputs, sessions, out, AlgorithmVersion::v1);
+            return;
+        }
+        const auto version = sessions.front().version();
+        for (const auto& session : sessions) {
+            if (session.version() != version) {
+                throw InvalidInputException("Prepared sessions in a batch must share an algorithm version");
+            }
+        }
+        compute_batch_impl(inputs, sessions, out, version);
     }
 
 private:
-    static std::array<uint8_t, 16> initialize_vector(const SessionParams& params) {
+    friend class HashStream;
+
+    template<typename Params>
+    static void compute_batch_impl(
+        std::span<const std::span<const uint8_t>> inputs,
+        std::span<const Params> params,
+        std::span<Hash> out,
+        AlgorithmVersion version
+    ) {
+        if (params.size() != inputs.size() || out.size() != inputs.size()) {
+            throw InvalidInputException("Batch inputs, params and outputs must have equal length");
+        }
+        uint64_t bytes = 0;
+        for (const auto& input : inputs) {
+            if (input.empty()) {
+                throw InvalidInputException("Input data cannot be empty");
+            }
+            bytes += input.size();
+        }
+        metrics::count(metrics::Op::hash, inputs.size(), bytes);
+
+        using Lanes = platform::ByteLanes16;
+        for (size_t i = 0; i < inputs.size(); i += Lanes::lanes) {
+            size_t count = std::min(Lanes::lanes, inputs.size() - i);
+            if (version == AlgorithmVersion::v1) {
+                compute_lanes<Lanes, Mt19937Generator>(inputs.subspan(i, count),
+                    params.subspan(i, count), out.subspan(i, count), version);
+            } else {
+                compute_lanes<Lanes, CounterGenerator>(inputs.subspan(i, count),
+                    params.subspan(i, count), out.subspan(i, count), version);
+            }
+        }
+    }
+
+    static Hash compute_unchecked(std::span<const uint8_t> input, const PreparedSession& session) noexcept {
+        metrics::ScopedTimer timer(metrics::Op::hash, input.size());
+        return digest(input, session);
+    }
+
+    static constexpr Hash digest(std::span<const uint8_t> input, const PreparedSession& session) noexcept {
+        Hash result{{}};
+
+        // Apply holographic transformation, followed by additional mixing
+        // rounds for better diffusion
+        if (session.version_ == AlgorithmVersion::v1) {
+            Mt19937Generator next_index(session.seed_);
+            apply_holographic_transform(input, session.iv_, result.get(), next_index, 4);
+        } else {
+            CounterGenerator next_index(session.seed_);
+            apply_holographic_transform(input, session.iv_, result.get(), next_index, 4);
+        }
+
+        return result;
+    }
+
+    static PreparedSession prepared(const SessionView& params, AlgorithmVersion version) {
+        return prepare(params, version);
+    }
+
+    static const PreparedSession& prepared(const PreparedSession& session, AlgorithmVersion) noexcept {
+        return session;
+    }
+
+    static constexpr std::array<uint8_t, 16> initialize_vector(
+        const SessionView& params,
+        AlgorithmVersion version
+    ) {
         std::array<uint8_t, 16> iv{};
         
-        // Mix session parameters into initialization vector
-        auto hash_component = [&](const auto& data, size_t offset) {
-            for (size_t i = 0; i < data.size() && i < 4; ++i) {
-                iv[offset + i] ^= data[i];
-                iv[offset + i] = platform::rotate_left(iv[offset + i], 3);
+        // Mix session parameters into initialization vector. v1 reads only
+        // the first 4 bytes of each address; v2 folds in a digest of every
+        // byte and the length, so IPv6 peers in one /32 and the same bytes
+        // in another address family get different IVs.
+        auto hash_component = [&](std::span<const uint8_t> data, size_t offset) {
+            if (version == AlgorithmVersion::v1) {
+                for (size_t i = 0; i < data.size() && i < 4; ++i) {
+                    iv[offset + i] ^= data[i];
+                    iv[offset + i] = platform::rotate_left(iv[offset + i], 3);
+                }
+                return;
+            }
+            const uint64_t h = digest64(data, offset);
+            for (size_t i = 0; i < 4; ++i) {
+                iv[offset + i] = static_cast<uint8_t>((h ^ (h >> 32)) >> (i * 8));
             }
         };
 
         hash_component(params.source_ip, 0);
         hash_component(params.dest_ip, 4);
         
-        // Include timestamp with better mixing
-        auto ts = params.timestamp.time_since_epoch().count();
+        // Include timestamp with better mixing. Clock tick length differs
+        // between standard libraries, so v2 always uses nanoseconds.
+        auto ts = version == AlgorithmVersion::v1
+            ? static_cast<int64_t>(params.timestamp.time_since_epoch().count())
+            : static_cast<int64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                  params.timestamp.time_since_epoch()).count());
         for (size_t i = 0; i < 8; ++i) {
             iv[8 + i] ^= static_cast<uint8_t>(ts >> (i * 8));
             iv[8 + i] = platform::rotate_left(iv[8 + i], i + 1);
@@ -57,63 +270,382 @@ private:
         return iv;
     }
 
-    static void apply_holographic_transform(
+    // The index generator is seeded from the IV contents, so digests are
+    // reproducible across calls and processes. All input bytes the rounds
+    // need are gathered up front so the state itself can stay in vector
+    // registers for the whole transform.
+    template<typename Generator>
+    static constexpr void apply_holographic_transform(
         std::span<const uint8_t> input,
         const std::array<uint8_t, 16>& iv,
-        std::array<uint8_t, 32>& result
+        std::array<uint8_t, 32>& result,
+        Generator& next_index,
+        size_t mix_rounds = 0
     ) {
-        std::mt19937_64 rng(std::bit_cast<uint64_t>(iv.data()));
-        
-        // Initialize result with input data using SIMD when possible
-        for (size_t i = 0; i < result.size(); i += platform::get_cache_line_size()) {
-            size_t chunk_size = std::min(platform::get_cache_line_size(), result.size() - i);
-            for (size_t j = 0; j < chunk_size; ++j) {
-                result[i + j] = input[(i + j) % input.size()];
-            }
+        constexpr size_t rounds = 8;
+
+        // Initialize result by repeating the input
+        for (size_t j = 0; j < result.size(); ++j) {
+            result[j] = input[j % input.size()];
         }
-        
-        // Multiple rounds of mixing for better diffusion
-        for (size_t round = 0; round < 8; ++round) {
-            // Process data in cache-line sized chunks
-            for (size_t i = 0; i < result.size(); i += platform::get_cache_line_size()) {
-                size_t chunk_size = std::min(platform::get_cache_line_size(), result.size() - i);
-                
-                // Mix with random input bytes using SIMD
-                std::array<uint8_t, 32> temp{};
-                for (size_t j = 0; j < chunk_size; ++j) {
-                    size_t idx = (rng() % input.size());
-                    temp[j] = input[idx];
-                }
-                platform::simd_xor_block(result.data() + i, temp.data(), chunk_size);
-                
-                // Apply rotations and additional mixing
-                for (size_t j = 0; j < chunk_size; ++j) {
-                    result[i + j] = platform::rotate_left(result[i + j], 3);
-                    result[i + j] += iv[j % iv.size()];
+
+        // Random input bytes mixed in by each round
+        alignas(32) std::array<uint8_t, rounds * 32> gathered;
+        for (auto& byte : gathered) {
+            byte = input[next_index(input.size())];
+        }
+
+        if (std::is_constant_evaluated()) {
+            platform::kernels::scalar::transform(result.data(), iv.data(), gathered.data(), rounds, mix_rounds);
+        } else {
+            platform::active_kernels().transform(result.data(), iv.data(), gathered.data(), rounds, mix_rounds);
+        }
+    }
+
+    static void mix_round(std::array<uint8_t, 32>& data) {
+        platform::active_kernels().mix_round(data.data());
+    }
+
+    // Multi-buffer variant of compute(). The state is kept transposed: row j
+    // holds byte j of every lane's hash, so the rotate/add steps and the
+    // neighbour mixing of mix_round() become whole-row vector operations.
+    // Only the generator draws and input gathers remain per lane.
+    template<typename Lanes, typename Generator, typename Params>
+    static void compute_lanes(
+        std::span<const std::span<const uint8_t>> inputs,
+        std::span<const Params> params,
+        std::span<Hash> out,
+        AlgorithmVersion version
+    ) {
+        constexpr size_t L = Lanes::lanes;
+        constexpr size_t rounds = 8;
+
+        alignas(64) std::array<std::array<uint8_t, L>, 32> rows{};
+        alignas(64) std::array<std::array<uint8_t, L>, 16> iv_rows{};
+        alignas(64) std::array<std::array<std::array<uint8_t, L>, 32>, rounds> gathered{};
+
+        for (size_t lane = 0; lane < inputs.size(); ++lane) {
+            auto input = inputs[lane];
+            const PreparedSession session = prepared(params[lane], version);
+            for (size_t j = 0; j < session.iv_.size(); ++j) {
+                iv_rows[j][lane] = session.iv_[j];
+            }
+            for (size_t j = 0; j < rows.size(); ++j) {
+                rows[j][lane] = input[j % input.size()];
+            }
+
+            // Draw every index this lane will need up front, in the same
+            // order as apply_holographic_transform()
+            Generator next_index(session.seed_);
+            for (size_t round = 0; round < rounds; ++round) {
+                for (size_t j = 0; j < rows.size(); ++j) {
+                    gathered[round][j][lane] = input[next_index(input.size())];
                 }
             }
-            
-            // Mix with neighboring bytes
-            mix_round(result);
+        }
+
+        std::array<Lanes, 32> state;
+        std::array<Lanes, 16> ivs;
+        for (size_t j = 0; j < state.size(); ++j) {
+            state[j] = Lanes::load(rows[j].data());
+        }
+        for (size_t j = 0; j < ivs.size(); ++j) {
+            ivs[j] = Lanes::load(iv_rows[j].data());
+        }
+
+        for (size_t round = 0; round < rounds; ++round) {
+            for (size_t j = 0; j < state.size(); ++j) {
+                auto x = state[j] ^ Lanes::load(gathered[round][j].data());
+                state[j] = x.template rotl<3>() + ivs[j % ivs.size()];
+            }
+            mix_round_lanes(state);
+        }
+
+        for (int round = 0; round < 4; ++round) {
+            mix_round_lanes(state);
+        }
+
+        for (size_t j = 0; j < state.size(); ++j) {
+            state[j].store(rows[j].data());
+        }
+        for (size_t lane = 0; lane < out.size(); ++lane) {
+            auto& digest = out[lane].get();
+            for (size_t j = 0; j < digest.size(); ++j) {
+                digest[j] = rows[j][lane];
+            }
         }
     }
 
-    static void mix_round(std::array<uint8_t, 32>& data) {
-        // Process in cache-line sized chunks for better cache utilization
-        for (size_t i = 0; i < data.size(); i += platform::get_cache_line_size()) {
-            size_t chunk_size = std::min(platform::get_cache_line_size(), data.size() - i);
-            
-            for (size_t j = 0; j < chunk_size; ++j) {
-                size_t idx = i + j;
-                uint8_t prev = data[(idx + data.size() - 1) % data.size()];
-                uint8_t next = data[(idx + 1) % data.size()];
-                
-                data[idx] = platform::rotate_left(data[idx], 3) ^ prev;
-                data[idx] = platform::rotate_left(data[idx], 2) ^ next;
-                data[idx] = platform::rotate_left(data[idx], 1);
+    template<typename Lanes>
+    static void mix_round_lanes(std::array<Lanes, 32>& state) {
+        // Same recurrence as mix_round(): each byte sees its already updated
+        // predecessor and its not yet updated successor
+        for (size_t idx = 0; idx < state.size(); ++idx) {
+            Lanes prev = state[(idx + state.size() - 1) % state.size()];
+            Lanes next = state[(idx + 1) % state.size()];
+
+            Lanes x = state[idx].template rotl<3>() ^ prev;
+            x = x.template rotl<2>() ^ next;
+            state[idx] = x.template rotl<1>();
+        }
+    }
+};
+
+// A HolographicHash with the digest width and round counts chosen at
+// compile time. Each instantiation gets its own transform with every loop
+// expanded (platform::kernels::fixed), seeded from the same PreparedSession
+// as HolographicHash. Narrower digests and fewer rounds gather and mix
+// proportionally fewer bytes. BasicHolographicHash<256, 8, 4> is
+// HolographicHash itself, vector kernels included, and returns Hash.
+template<size_t Bits, size_t Rounds, size_t MixRounds = Rounds / 2>
+class BasicHolographicHash {
+    static_assert(Bits >= 64 && Bits <= 1024 && Bits % 64 == 0, "Digest width must be a multiple of 64 bits up to 1024");
+    static_assert(Rounds > 0, "At least one transform round is needed");
+
+public:
+    static constexpr size_t bits = Bits;
+    static constexpr size_t bytes = Bits / 8;
+    static constexpr size_t rounds = Rounds;
+    static constexpr size_t mix_rounds = MixRounds;
+
+    using Digest = holohash::Digest<Bits>;
+
+    static constexpr Digest compute(
+        std::span<const uint8_t> input,
+        const SessionView& params,
+        AlgorithmVersion version = AlgorithmVersion::v1
+    ) {
+        return compute(input, HolographicHash::prepare(params, version));
+    }
+
+    static constexpr Digest compute(std::span<const uint8_t> input, const PreparedSession& session) {
+        if constexpr (is_default) {
+            return HolographicHash::compute(input, session);
+        } else {
+            if (input.empty()) {
+                throw InvalidInputException("Input data cannot be empty");
+            }
+            if (std::is_constant_evaluated()) {
+                return digest(input, session);
             }
+            return timed_digest(input, session);
         }
     }
+
+    static HashResult<Digest> try_compute(
+        std::span<const uint8_t> input,
+        const SessionView& params,
+        AlgorithmVersion version = AlgorithmVersion::v1
+    ) noexcept {
+        return try_compute(input, HolographicHash::prepare(params, version));
+    }
+
+    static HashResult<Digest> try_compute(std::span<const uint8_t> input, const PreparedSession& session) noexcept {
+        if constexpr (is_default) {
+            return HolographicHash::try_compute(input, session);
+        } else {
+            if (input.empty()) {
+                return ErrorCode::empty_input;
+            }
+            return timed_digest(input, session);
+        }
+    }
+
+private:
+    static constexpr bool is_default = Bits == 256 && Rounds == 8 && MixRounds == 4;
+
+    static Digest timed_digest(std::span<const uint8_t> input, const PreparedSession& session) noexcept {
+        metrics::ScopedTimer timer(metrics::Op::hash, input.size());
+        return digest(input, session);
+    }
+
+    static constexpr Digest digest(std::span<const uint8_t> input, const PreparedSession& session) noexcept {
+        if (session.version_ == AlgorithmVersion::v1) {
+            Mt19937Generator next_index(session.seed_);
+            return transform(input, session.iv_, next_index);
+        }
+        CounterGenerator next_index(session.seed_);
+        return transform(input, session.iv_, next_index);
+    }
+
+    // Same steps as HolographicHash::apply_holographic_transform
+    template<typename Generator>
+    static constexpr Digest transform(
+        std::span<const uint8_t> input,
+        const std::array<uint8_t, 16>& iv,
+        Generator& next_index
+    ) noexcept {
+        Digest result{{}};
+        auto& state = result.get();
+        for (size_t j = 0; j < bytes; ++j) {
+            state[j] = input[j % input.size()];
+        }
+
+        alignas(32) std::array<uint8_t, Rounds * bytes> gathered;
+        for (auto& byte : gathered) {
+            byte = input[next_index(input.size())];
+        }
+
+        platform::kernels::fixed::transform<bytes, Rounds, MixRounds>(state, iv, gathered);
+        return result;
+    }
 };
 
+// Named profiles. StandardHash is today's HolographicHash; FastHash suits
+// 128-bit sharding and dedupe keys; StrongHash widens to 512 bits and
+// doubles the rounds.
+using FastHash = BasicHolographicHash<128, 4>;
+using StandardHash = BasicHolographicHash<256, 8>;
+using StrongHash = BasicHolographicHash<512, 16>;
+
+// Incremental hasher for inputs that do not fit in a single buffer.
+// Input is absorbed in fixed-size blocks; each block goes through the
+// holographic transform on its own and is chained into a 32-byte state, so
+// memory use is bounded by block_size regardless of the total input length.
+// Digests depend only on the concatenated input, never on how it was split
+// into update() calls, but they differ from HolographicHash::compute().
+// Streams always use the v2 generator and IV encoding.
+class HashStream {
+public:
+    static constexpr size_t block_size = 4096;
+
+    explicit HashStream(const SessionView& params)
+        : iv_(HolographicHash::initialize_vector(params, AlgorithmVersion::v2)) {}
+
+private:
+    friend class HolographicHash;
+
+    explicit HashStream(const std::array<uint8_t, 16>& iv) : iv_(iv) {}
+
+public:
+
+    void update(std::span<const uint8_t> chunk) {
+        total_size_ += chunk.size();
+
+        // Top up a partially filled block first
+        if (buffered_ > 0) {
+            size_t take = std::min(chunk.size(), block_size - buffered_);
+            std::copy_n(chunk.begin(), take, buffer_.begin() + buffered_);
+            buffered_ += take;
+            chunk = chunk.subspan(take);
+            if (buffered_ < block_size) {
+                return;
+            }
+            absorb_block(std::span<const uint8_t>(buffer_.data(), block_size), chain_, block_index_++);
+            buffered_ = 0;
+        }
+
+        // Full blocks are absorbed straight from the caller's buffer
+        while (chunk.size() >= block_size) {
+            absorb_block(chunk.first(block_size), chain_, block_index_++);
+            chunk = chunk.subspan(block_size);
+        }
+
+        std::copy(chunk.begin(), chunk.end(), buffer_.begin());
+        buffered_ = chunk.size();
+    }
+
+    // Produces the digest of everything absorbed so far. The stream itself
+    // is left untouched, so more data may still be appended afterwards.
+    Hash finalize() const {
+        if (total_size_ == 0) {
+            throw InvalidInputException("Input data cannot be empty");
+        }
+
+        auto result = chain_;
+        if (buffered_ > 0) {
+            absorb_block(std::span<const uint8_t>(buffer_.data(), buffered_), result, block_index_);
+        }
+
+        // Bind the total length so that block-aligned prefixes differ
+        for (size_t i = 0; i < 8; ++i) {
+            result[24 + i] ^= static_cast<uint8_t>(total_size_ >> (i * 8));
+        }
+
+        for (int round = 0; round < 4; ++round) {
+            HolographicHash::mix_round(result);
+        }
+
+        return Hash{result};
+    }
+
+    uint64_t size() const noexcept { return total_size_; }
+
+private:
+    std::array<uint8_t, 16> iv_;
+    std::array<uint8_t, 32> chain_{};
+    std::array<uint8_t, block_size> buffer_{};
+    size_t buffered_ = 0;
+    uint64_t block_index_ = 0;
+    uint64_t total_size_ = 0;
+
+    void absorb_block(
+        std::span<const uint8_t> block,
+        std::array<uint8_t, 32>& chain,
+        uint64_t index
+    ) const {
+        // Derive a per-block IV so that identical blocks at different
+        // offsets contribute differently
+        auto block_iv = iv_;
+        for (size_t i = 0; i < 8; ++i) {
+            block_iv[i] ^= static_cast<uint8_t>(index >> (i * 8));
+        }
+
+        std::array<uint8_t, 32> digest{};
+        CounterGenerator next_index(block_iv);
+        HolographicHash::apply_holographic_transform(block, block_iv, digest, next_index);
+
+        platform::simd_xor_block(chain.data(), digest.data(), chain.size());
+        HolographicHash::mix_round(chain);
+    }
+};
+
+inline Hash HolographicHash::compute_tree(
+    std::span<const uint8_t> input,
+    const SessionView& params,
+    const TreeParams& tree
+) {
+    if (input.empty()) {
+        throw InvalidInputException("Input data cannot be empty");
+    }
+    if (tree.chunk_size == 0 || tree.chunk_size % HashStream::block_size != 0) {
+        throw InvalidInputException("Tree chunk size must be a positive multiple of the stream block size");
+    }
+
+    const auto iv = initialize_vector(params, AlgorithmVersion::v2);
+    const size_t leaves = (input.size() + tree.chunk_size - 1) / tree.chunk_size;
+
+    // Leaf i is a stream over its chunk, keyed by i + 1 in the upper IV half
+    std::vector<Hash> digests(leaves, Hash{{}});
+    ThreadPool& pool = tree.pool ? *tree.pool : ThreadPool::shared();
+    pool.parallel_for(leaves, [&](size_t leaf) {
+        auto leaf_iv = iv;
+        for (size_t i = 0; i < 8; ++i) {
+            leaf_iv[8 + i] ^= static_cast<uint8_t>((leaf + 1) >> (i * 8));
+        }
+        HashStream stream(leaf_iv);
+        stream.update(input.subspan(leaf * tree.chunk_size,
+                                    std::min(tree.chunk_size, input.size() - leaf * tree.chunk_size)));
+        digests[leaf] = stream.finalize();
+    });
+
+    // The root IV has the upper half inverted, which no leaf index reaches
+    auto root_iv = iv;
+    for (size_t i = 8; i < 16; ++i) {
+        root_iv[i] = static_cast<uint8_t>(~root_iv[i]);
+    }
+    std::array<uint8_t, 16> header{};
+    for (size_t i = 0; i < 8; ++i) {
+        header[i] = static_cast<uint8_t>(static_cast<uint64_t>(tree.chunk_size) >> (i * 8));
+        header[8 + i] = static_cast<uint8_t>(static_cast<uint64_t>(input.size()) >> (i * 8));
+    }
+
+    HashStream root(root_iv);
+    root.update(header);
+    for (const auto& digest : digests) {
+        root.update(digest.get());
+    }
+    return root.finalize();
+}
+
 } // namespace holohash
@@ -0,0 +1,133 @@
+#pragma once
+#include "types.hpp"
+#include "generator.hpp"
+#include "platform.hpp"
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <vector>
+
+namespace holohash {
+
+// Shape and estimated accuracy of a KeyFilter, see Keychain::filter_stats()
+struct FilterStats {
+    size_t bytes = 0;
+    size_t capacity = 0;            // insertions before the next rebuild
+    size_t inserted = 0;            // insertions since the last rebuild
+    uint64_t rebuilds = 0;
+    double false_positive_rate = 0; // estimated from the bits set
+};
+
+// Split-block Bloom filter over keys, used by Keychain to reject unknown
+// keys before probing its hash table. Each key maps to one cache-line block
+// of eight 64-bit words and sets one bit in every word, so a lookup reads a
+// single cache line and has no false negatives.
+//
+// Bits cannot be cleared, so removed keys stay behind until the owner
+// rebuilds the filter from its live keys. The filter is sized for twice
+// the expected key count and wants a rebuild once that many keys went in
+// since the last one; the owner reinserts at most half of that, so
+// rebuilding costs amortised O(1) per insertion.
+class KeyFilter {
+public:
+    KeyFilter() noexcept = default;
+
+    KeyFilter(size_t expected_keys, size_t bits_per_key) : bits_per_key_(bits_per_key) {
+        allocate(expected_keys);
+    }
+
+    bool enabled() const noexcept { return !blocks_.empty(); }
+
+    void insert(const Key& key) noexcept {
+        const uint64_t h = detail::load_le64(key.get().data() + 24);
+        auto& block = blocks_[block_index(key)];
+        for (size_t i = 0; i < word_count; ++i) {
+            block.words[i] |= bit(h, i);
+        }
+        ++inserted_;
+    }
+
+    // False only if the key was never inserted since the last reset
+    bool may_contain(const Key& key) const noexcept {
+        const uint64_t h = detail::load_le64(key.get().data() + 24);
+        const auto& block = blocks_[block_index(key)];
+        uint64_t missing = 0;
+        for (size_t i = 0; i < word_count; ++i) {
+            missing |= bit(h, i) & ~block.words[i];
+        }
+        return missing == 0;
+    }
+
+    bool needs_rebuild() const noexcept { return inserted_ >= capacity_; }
+
+    // Clears the filter and resizes it for live_keys, never below the
+    // expected count it was created with; the owner then reinserts them
+    void reset(size_t live_keys) {
+        allocate(live_keys);
+        ++rebuilds_;
+    }
+
+    // Walks every block, so meant for monitoring rather than the hot path
+    FilterStats stats() const noexcept {
+        FilterStats stats;
+        stats.bytes = blocks_.size() * sizeof(Block);
+        stats.capacity = capacity_;
+        stats.inserted = inserted_;
+        stats.rebuilds = rebuilds_;
+
+        // A random key passes a block only if its bit is set in every word
+        double sum = 0;
+        for (const auto& block : blocks_) {
+            double pass = 1;
+            for (uint64_t word : block.words) {
+                pass *= std::popcount(word) / 64.0;
+            }
+            sum += pass;
+        }
+        stats.false_positive_rate = blocks_.empty() ? 0 : sum / blocks_.size();
+        return stats;
+    }
+
+private:
+    static constexpr size_t word_count = 8;
+    static constexpr size_t block_bits = word_count * 64;
+
+    struct alignas(platform::get_cache_line_size()) Block {
+        std::array<uint64_t, word_count> words{};
+    };
+
+    // Odd multipliers of the Parquet split-block filter, one per word
+    static constexpr std::array<uint32_t, word_count> salts = {
+        0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+        0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U
+    };
+
+    std::vector<Block> blocks_;
+    size_t bits_per_key_ = 0;
+    size_t expected_ = 0;
+    size_t capacity_ = 0;
+    size_t inserted_ = 0;
+    uint64_t rebuilds_ = 0;
+
+    void allocate(size_t live_keys) {
+        expected_ = std::max(expected_, live_keys);
+        capacity_ = 2 * std::max<size_t>(expected_, 1);
+        const size_t bits = capacity_ * std::max<size_t>(bits_per_key_, 1);
+        blocks_.assign(std::max<size_t>((bits + block_bits - 1) / block_bits, 1), Block{});
+        inserted_ = 0;
+    }
+
+    // Keys are uniformly distributed, so their bits are used directly: the
+    // leading word picks the keychain shard and the next one hash buckets,
+    // so the filter takes the third word for the block and the fourth for
+    // the bits
+    size_t block_index(const Key& key) const noexcept {
+        return static_cast<size_t>(detail::mul_hi64(detail::load_le64(key.get().data() + 16), blocks_.size()));
+    }
+
+    static uint64_t bit(uint64_t h, size_t i) noexcept {
+        return uint64_t{1} << ((static_cast<uint32_t>(h) * salts[i]) >> 26);
+    }
+};
+
+} // namespace holohash
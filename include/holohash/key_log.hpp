@@ -0,0 +1,314 @@
+#pragma once
+#include "flat_key_store.hpp"
+#include "platform.hpp"
+#include "exceptions.hpp"
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <thread>
+
+namespace holohash {
+
+struct KeyLogOptions {
+    // Group commit window: an appended entry reaches the disk at most this
+    // long after it was appended, or sooner once half the buffer is full
+    std::chrono::microseconds flush_interval{10000};
+
+    // Ring buffer size in entries, rounded up to a power of two. append()
+    // waits for the writer when the ring is full.
+    size_t buffer_entries = size_t{1} << 16;
+
+    // Flush each group to stable storage, not just to the OS
+    bool sync = true;
+};
+
+// Append-only write-ahead log of FlatKeychain mutations. append() copies a
+// fixed-size entry into a single-producer ring buffer and returns; a
+// writer thread drains the ring in groups, one write and one sync per
+// group. The file is a 16-byte header followed by Entry records;
+// replay() reads it back and stops at the first torn or corrupt entry.
+// Opening an existing log cuts it back to its last intact entry, so new
+// entries are never appended behind a damaged one.
+//
+// append() must not be called concurrently; flush() and the destructor may
+// be called from any thread.
+class KeyLog {
+public:
+    enum class Op : uint8_t {
+        insert = 1,     // key with its record, replaces any earlier one
+        evict = 2,
+        revoke = 3
+    };
+
+    struct Entry {
+        Op op;
+        uint8_t reserved[3];
+        uint32_t check;     // low half of digest64 over the rest
+        std::array<uint8_t, 32> key;
+        KeyRecord record;
+    };
+
+    static_assert(sizeof(Entry) == 72);
+
+    static constexpr uint32_t format_version = 1;
+    static constexpr std::array<char, 8> magic{'H', 'O', 'L', 'O', 'W', 'A', 'L', '1'};
+
+    explicit KeyLog(const std::string& path, const KeyLogOptions& options = {})
+        : path_(path),
+          options_(options),
+          mask_(std::bit_ceil(std::max<size_t>(options.buffer_entries, 2)) - 1),
+          ring_(std::make_unique<Entry[]>(mask_ + 1)) {
+        std::error_code error;
+        const bool exists = std::filesystem::exists(path, error) && std::filesystem::file_size(path, error) > 0;
+        if (exists) {
+            const auto intact = sizeof(Header) + replay(path, [](const Entry&) {}) * sizeof(Entry);
+            if (std::filesystem::file_size(path, error) > intact) {
+                std::filesystem::resize_file(path, intact, error);
+                if (error) {
+                    throw KeychainException("Cannot truncate key log " + path);
+                }
+            }
+        }
+
+        file_ = std::fopen(path.c_str(), "ab");
+        if (!file_) {
+            throw KeychainException("Cannot open key log " + path);
+        }
+        if (!exists) {
+            Header header{magic, format_version, static_cast<uint32_t>(sizeof(Entry))};
+            if (std::fwrite(&header, sizeof(header), 1, file_) != 1 || !sync_file()) {
+                std::fclose(file_);
+                throw KeychainException("Cannot write key log " + path);
+            }
+        }
+
+        writer_ = std::thread([this] { run(); });
+    }
+
+    KeyLog(const KeyLog&) = delete;
+    KeyLog& operator=(const KeyLog&) = delete;
+
+    // Writes out everything appended so far
+    ~KeyLog() {
+        {
+            std::lock_guard lock(mutex_);
+            stop_ = true;
+        }
+        wake_.notify_one();
+        writer_.join();
+        std::fclose(file_);
+    }
+
+    // Hot path: one entry copy and a release store; the checksum is left to
+    // the writer. Throws once the writer has failed, so callers learn that
+    // durability is lost.
+    void append(Op op, const uint8_t* key, const KeyRecord& record) {
+        if (failed_.load(std::memory_order_relaxed)) {
+            throw KeychainException("Key log " + path_ + " is no longer writable");
+        }
+
+        const uint64_t head = head_.load(std::memory_order_relaxed);
+        if (head - tail_.load(std::memory_order_acquire) > mask_) {
+            wait_for_space(head);
+        }
+
+        Entry& entry = ring_[head & mask_];
+        entry.op = op;
+        std::memcpy(entry.key.data(), key, entry.key.size());
+        entry.record = record;
+        head_.store(head + 1, std::memory_order_release);
+
+        if (((head + 1) & (mask_ >> 1)) == 0) {
+            wake_.notify_one();
+        }
+    }
+
+    // Blocks until every entry appended before the call is on disk
+    void flush() {
+        const uint64_t target = head_.load(std::memory_order_acquire);
+        std::unique_lock lock(mutex_);
+        flush_requested_ = true;
+        wake_.notify_one();
+        done_.wait(lock, [&] { return durable_ >= target || failed_.load(); });
+        if (failed_.load()) {
+            throw KeychainException("Key log " + path_ + " is no longer writable");
+        }
+    }
+
+    // Drops all entries, e.g. once a snapshot covers them. Entries appended
+    // concurrently with truncate() may be lost.
+    void truncate() {
+        flush();
+        std::lock_guard lock(mutex_);
+        std::error_code error;
+        std::filesystem::resize_file(path_, sizeof(Header), error);
+        if (error) {
+            throw KeychainException("Cannot truncate key log " + path_);
+        }
+    }
+
+    uint64_t appended() const noexcept { return head_.load(std::memory_order_relaxed); }
+    uint64_t groups_written() const noexcept { return groups_.load(std::memory_order_relaxed); }
+    const std::string& path() const noexcept { return path_; }
+
+    // Calls apply(const Entry&) for every intact entry of the log at path
+    // in order and returns how many there were. A missing file is an empty
+    // log; a torn final entry ends the replay.
+    template<typename Apply>
+    static uint64_t replay(const std::string& path, Apply&& apply) {
+        std::error_code error;
+        if (!std::filesystem::exists(path, error)) {
+            return 0;
+        }
+        check_header(path);
+
+        platform::MappedFile file;
+        if (!file.open(path.c_str(), platform::MappedFile::Access::sequential)) {
+            throw KeychainException("Cannot open key log " + path);
+        }
+
+        uint64_t count = 0;
+        Entry entry;
+        for (size_t offset = sizeof(Header); offset + sizeof(Entry) <= file.size(); offset += sizeof(Entry)) {
+            std::memcpy(&entry, file.data() + offset, sizeof(Entry));
+            if (entry.check != checksum(entry)) {
+                break;
+            }
+            apply(static_cast<const Entry&>(entry));
+            ++count;
+        }
+        return count;
+    }
+
+private:
+    struct Header {
+        std::array<char, 8> magic;
+        uint32_t format_version;
+        uint32_t entry_size;
+    };
+
+    std::string path_;
+    KeyLogOptions options_;
+    size_t mask_;
+    std::unique_ptr<Entry[]> ring_;
+    std::FILE* file_ = nullptr;
+
+    // head_ is written by append(), tail_ and durable_ by the writer
+    alignas(platform::get_cache_line_size()) std::atomic<uint64_t> head_{0};
+    alignas(platform::get_cache_line_size()) std::atomic<uint64_t> tail_{0};
+    std::atomic<uint64_t> groups_{0};
+    std::atomic<bool> failed_{false};
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable done_;
+    uint64_t durable_ = 0;
+    bool flush_requested_ = false;
+    bool stop_ = false;
+    std::thread writer_;
+
+    static uint32_t checksum(const Entry& entry) noexcept {
+        std::array<uint8_t, sizeof(Entry) - offsetof(Entry, key) + 1> bytes;
+        bytes[0] = static_cast<uint8_t>(entry.op);
+        std::memcpy(bytes.data() + 1, &entry.key, bytes.size() - 1);
+        return static_cast<uint32_t>(digest64(bytes));
+    }
+
+    static void check_header(const std::string& path) {
+        std::FILE* file = std::fopen(path.c_str(), "rb");
+        Header header{};
+        const bool read = file && std::fread(&header, sizeof(header), 1, file) == 1;
+        if (file) {
+            std::fclose(file);
+        }
+        if (!read || header.magic != magic) {
+            throw KeychainException("Invalid key log " + path + ": not a key log");
+        }
+        if (header.format_version != format_version || header.entry_size != sizeof(Entry)) {
+            throw KeychainException("Invalid key log " + path + ": unsupported format");
+        }
+    }
+
+    bool sync_file() noexcept {
+        if (std::fflush(file_) != 0) {
+            return false;
+        }
+#if defined(__linux__)
+        return !options_.sync || ::fdatasync(::fileno(file_)) == 0;
+#elif defined(__APPLE__)
+        return !options_.sync || ::fsync(::fileno(file_)) == 0;
+#else
+        return true;
+#endif
+    }
+
+    void wait_for_space(uint64_t head) {
+        std::unique_lock lock(mutex_);
+        flush_requested_ = true;
+        wake_.notify_one();
+        done_.wait(lock, [&] { return head - tail_.load(std::memory_order_acquire) <= mask_ || failed_.load(); });
+        if (failed_.load()) {
+            throw KeychainException("Key log " + path_ + " is no longer writable");
+        }
+    }
+
+    // Writer thread: one group per wake-up
+    void run() {
+        std::unique_lock lock(mutex_);
+        for (;;) {
+            wake_.wait_for(lock, options_.flush_interval, [this] {
+                return stop_ || flush_requested_ ||
+                       head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_relaxed) > mask_ / 2;
+            });
+            flush_requested_ = false;
+
+            const uint64_t tail = tail_.load(std::memory_order_relaxed);
+            const uint64_t head = head_.load(std::memory_order_acquire);
+            if (head != tail) {
+                // Once a group failed, entries that raced past append()'s
+                // check are dropped, so the ring still drains and stop_ can
+                // end the thread
+                if (!failed_.load()) {
+                    if (write_group(tail, head)) {
+                        groups_.fetch_add(1, std::memory_order_relaxed);
+                    } else {
+                        failed_.store(true);
+                    }
+                }
+                tail_.store(head, std::memory_order_release);
+                durable_ = head;
+            }
+            done_.notify_all();
+
+            if (stop_ && head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_relaxed)) {
+                return;
+            }
+        }
+    }
+
+    // Entries [tail, head) in at most two writes, as the range may wrap.
+    // The writer owns these slots until tail_ moves past them.
+    bool write_group(uint64_t tail, uint64_t head) noexcept {
+        const size_t capacity = mask_ + 1;
+        const size_t first = tail & mask_;
+        const size_t count = static_cast<size_t>(head - tail);
+        const size_t run = std::min(count, capacity - first);
+        for (uint64_t i = tail; i != head; ++i) {
+            ring_[i & mask_].check = checksum(ring_[i & mask_]);
+        }
+        return std::fwrite(&ring_[first], sizeof(Entry), run, file_) == run &&
+               std::fwrite(&ring_[0], sizeof(Entry), count - run, file_) == count - run &&
+               sync_file();
+    }
+};
+
+} // namespace holohash
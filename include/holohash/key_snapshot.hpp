@@ -0,0 +1,206 @@
+#pragma once
+#include "flat_key_store.hpp"
+#include "generator.hpp"
+#include "nonce.hpp"
+#include "exceptions.hpp"
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <span>
+#include <string>
+
+namespace holohash {
+
+// Key snapshot file header. A snapshot is this header followed by the slab
+// image of a FlatKeyStore<KeyRecord> with `capacity` slots, so a mapped
+// snapshot is probed exactly like the live table. Integers are
+// little-endian.
+//
+//   offset 0    SnapshotHeader
+//   offset 64   control bytes
+//   + FlatKeyStore<KeyRecord>::keys_offset(capacity)      keys
+//   + FlatKeyStore<KeyRecord>::records_offset(capacity)   KeyRecords
+struct SnapshotHeader {
+    std::array<char, 8> magic;
+    uint32_t format_version;
+    uint32_t record_size;
+    uint64_t capacity;
+    uint64_t size;
+    int64_t created_at;         // nanoseconds since the epoch
+    uint8_t algorithm_version;
+    uint8_t nonce_mode;
+    uint8_t reserved[6];
+    uint64_t check;             // digest64 of the preceding 48 bytes
+    uint64_t reserved2;
+};
+
+static_assert(sizeof(SnapshotHeader) == 64);
+
+// Read-only view of a key snapshot file. Opening maps the file and checks
+// the header; nothing else is read or copied, so opening costs the same for
+// any key count, and pages are faulted in as find() touches them.
+class KeySnapshot {
+public:
+    using Store = FlatKeyStore<KeyRecord>;
+
+    static constexpr uint32_t format_version = 1;
+    static constexpr std::array<char, 8> magic{'H', 'O', 'L', 'O', 'K', 'E', 'Y', 'S'};
+
+    explicit KeySnapshot(const std::string& path) {
+        require_little_endian();
+        if (!file_.open(path.c_str(), platform::MappedFile::Access::random)) {
+            throw KeychainException("Cannot open key snapshot " + path);
+        }
+
+        if (file_.size() < sizeof(SnapshotHeader)) {
+            fail(path, "too short");
+        }
+        std::memcpy(&header_, file_.data(), sizeof(header_));
+        if (header_.magic != magic) {
+            fail(path, "not a key snapshot");
+        }
+        if (header_.format_version != format_version) {
+            fail(path, "unsupported format version " + std::to_string(header_.format_version));
+        }
+        if (header_.check != header_check(header_)) {
+            fail(path, "header is corrupt");
+        }
+        if (header_.record_size != sizeof(KeyRecord) ||
+            header_.capacity < Store::min_capacity || !std::has_single_bit(header_.capacity) ||
+            header_.size > header_.capacity ||
+            file_.size() - sizeof(SnapshotHeader) < Store::bytes_for(header_.capacity)) {
+            fail(path, "inconsistent table layout");
+        }
+
+        const uint8_t* table = file_.data() + sizeof(SnapshotHeader);
+        ctrl_ = table;
+        keys_ = table + Store::keys_offset(header_.capacity);
+        records_ = reinterpret_cast<const KeyRecord*>(table + Store::records_offset(header_.capacity));
+    }
+
+    KeySnapshot(const KeySnapshot&) = delete;
+    KeySnapshot& operator=(const KeySnapshot&) = delete;
+
+    const KeyRecord* find(const Key& key) const noexcept {
+        size_t slot = find_slot(key);
+        return slot == Store::npos ? nullptr : &records_[slot];
+    }
+
+    // Slot holding key, or Store::npos
+    size_t find_slot(const Key& key) const noexcept {
+        size_t slot = flat_group::find(ctrl_, keys_, capacity(), key.get().data());
+        return slot == capacity() ? Store::npos : slot;
+    }
+
+    size_t size() const noexcept { return header_.size; }
+    size_t capacity() const noexcept { return header_.capacity; }
+    AlgorithmVersion version() const noexcept { return static_cast<AlgorithmVersion>(header_.algorithm_version); }
+    NonceMode nonce_mode() const noexcept { return static_cast<NonceMode>(header_.nonce_mode); }
+    std::chrono::system_clock::time_point created_at() const noexcept {
+        return std::chrono::system_clock::time_point(
+            std::chrono::duration_cast<std::chrono::system_clock::duration>(
+                std::chrono::nanoseconds(header_.created_at)));
+    }
+
+    // Slot access for sweeps over the whole table
+    bool occupied(size_t slot) const noexcept { return (ctrl_[slot] & 0x80) == 0; }
+    const uint8_t* key_at(size_t slot) const noexcept { return keys_ + slot * Store::key_size; }
+    const KeyRecord& record(size_t slot) const noexcept { return records_[slot]; }
+
+    // Writes store to path. The file is written next to path, flushed to
+    // disk and renamed over it, and the directory is synced, so readers see
+    // either the old snapshot or the complete new one, and the new one once
+    // write() returns.
+    static void write(
+        const std::string& path,
+        const Store& store,
+        AlgorithmVersion version,
+        NonceMode nonce_mode
+    ) {
+        require_little_endian();
+
+        SnapshotHeader header{};
+        header.magic = magic;
+        header.format_version = format_version;
+        header.record_size = sizeof(KeyRecord);
+        header.capacity = store.capacity();
+        header.size = store.size();
+        header.created_at = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        header.algorithm_version = static_cast<uint8_t>(version);
+        header.nonce_mode = static_cast<uint8_t>(nonce_mode);
+        header.check = header_check(header);
+
+        const std::string temp = path + ".tmp";
+        std::FILE* file = std::fopen(temp.c_str(), "wb");
+        if (!file) {
+            throw KeychainException("Cannot create key snapshot " + temp);
+        }
+        bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+                  std::fwrite(store.data(), Store::bytes_for(store.capacity()), 1, file) == 1 &&
+                  std::fflush(file) == 0;
+#if defined(__linux__) || defined(__APPLE__)
+        ok = ok && ::fsync(::fileno(file)) == 0;
+#endif
+        ok = std::fclose(file) == 0 && ok;
+
+        std::error_code error;
+        if (ok) {
+            std::filesystem::rename(temp, path, error);
+        }
+        if (!ok || error) {
+            std::filesystem::remove(temp, error);
+            throw KeychainException("Cannot write key snapshot " + path);
+        }
+        if (!sync_directory(path)) {
+            throw KeychainException("Cannot write key snapshot " + path + ": directory sync failed");
+        }
+    }
+
+private:
+    platform::MappedFile file_;
+    SnapshotHeader header_{};
+    const uint8_t* ctrl_ = nullptr;
+    const uint8_t* keys_ = nullptr;
+    const KeyRecord* records_ = nullptr;
+
+    static void require_little_endian() {
+        if constexpr (std::endian::native != std::endian::little) {
+            throw KeychainException("Key snapshots need a little-endian host");
+        }
+    }
+
+    // Makes the rename onto path durable: it lives in the directory entry,
+    // which the file's own fsync does not cover
+    static bool sync_directory(const std::string& path) noexcept {
+#if defined(__linux__) || defined(__APPLE__)
+        std::error_code error;
+        std::filesystem::path parent = std::filesystem::absolute(path, error).parent_path();
+        if (error) {
+            return false;
+        }
+        const int fd = ::open(parent.c_str(), O_RDONLY | O_DIRECTORY);
+        if (fd < 0) {
+            return false;
+        }
+        const bool ok = ::fsync(fd) == 0;
+        return ::close(fd) == 0 && ok;
+#else
+        (void)path;
+        return true;
+#endif
+    }
+
+    [[noreturn]] static void fail(const std::string& path, const std::string& reason) {
+        throw KeychainException("Invalid key snapshot " + path + ": " + reason);
+    }
+
+    static uint64_t header_check(const SnapshotHeader& header) noexcept {
+        return digest64(std::span<const uint8_t>(reinterpret_cast<const uint8_t*>(&header),
+                                                 offsetof(SnapshotHeader, check)));
+    }
+};
+
+} // namespace holohash
@@ -3,68 +3,552 @@
 #include "hash.hpp"
 #include "nonce.hpp"
 #include "exceptions.hpp"
+#include "result.hpp"
+#include "timer_wheel.hpp"
+#include "key_filter.hpp"
+#include "thread_pool.hpp"
 #include <unordered_map>
+#include <utility>
+#include <atomic>
+#include <chrono>
+#include <new>
+#include <vector>
 
 namespace holohash {
 
+// Construction options for Keychain. Zero limits mean unbounded.
+struct KeychainOptions {
+    AlgorithmVersion version = AlgorithmVersion::v1;
+    NonceMode nonce_mode = NonceMode::recursive;
+
+    // Evict once either budget would be exceeded. Bytes are the estimated
+    // footprint of each entry including its heap-allocated context.
+    size_t max_keys = 0;
+    size_t max_bytes = 0;
+
+    // Keys expire ttl after their SessionParams::timestamp; expiry is
+    // tracked with expiry_resolution granularity
+    std::chrono::system_clock::duration ttl{0};
+    std::chrono::system_clock::duration expiry_resolution = std::chrono::seconds(1);
+
+    // FlatKeychain only: back the table with huge pages where available
+    bool huge_pages = false;
+
+    // Keychain and ConcurrentKeychain only: expected number of keys for a
+    // KeyFilter in front of the key store, which rejects most unknown keys
+    // with one cache-line read instead of a hash table probe. 0 disables it.
+    size_t filter_keys = 0;
+    size_t filter_bits_per_key = 10;
+};
+
+struct KeychainStats {
+    size_t keys = 0;
+    size_t bytes = 0;
+    uint64_t evictions = 0;
+    uint64_t expirations = 0;
+};
+
+// Hash table shape of a Keychain, see Keychain::table_stats()
+struct TableStats {
+    size_t keys = 0;
+    size_t buckets = 0;
+    double load_factor = 0;
+    size_t empty_buckets = 0;
+    size_t longest_chain = 0;
+};
+
 class Keychain {
 public:
+    explicit Keychain(
+        AlgorithmVersion version = AlgorithmVersion::v1,
+        NonceMode nonce_mode = NonceMode::recursive
+    ) : Keychain(KeychainOptions{version, nonce_mode}) {}
+
+    explicit Keychain(const KeychainOptions& options)
+        : options_(options),
+          resolution_(std::max(options.expiry_resolution, std::chrono::system_clock::duration{1})),
+          wheel_(to_tick(std::chrono::system_clock::now())) {
+        if (options.filter_keys != 0) {
+            filter_ = KeyFilter(options.filter_keys, options.filter_bits_per_key);
+        }
+    }
+
+    // The map's nodes move with it, so the CLOCK ring and timer wheel links
+    // stay valid here; other is left as an empty keychain
+    Keychain(Keychain&& other) noexcept
+        : options_(other.options_),
+          resolution_(other.resolution_),
+          wheel_(other.wheel_.now()) {
+        take(other);
+    }
+
+    Keychain& operator=(Keychain&& other) noexcept {
+        if (this != &other) {
+            options_ = other.options_;
+            resolution_ = other.resolution_;
+            take(other);
+        }
+        return *this;
+    }
+
+    // Accumulates a key's input incrementally, e.g. while an upload is
+    // still arriving. Pass the finished stream to generate_key().
+    class KeyStream {
+    public:
+        KeyStream(const SessionView& params, const StateView& state)
+            : hash_(params), nonce_(state), params_(params.to_params()), state_(state.to_state()) {}
+
+        KeyStream(SessionParams&& params, SystemState&& state)
+            : hash_(params), nonce_(state), params_(std::move(params)), state_(std::move(state)) {}
+
+        void update(std::span<const uint8_t> chunk) {
+            hash_.update(chunk);
+            nonce_.update(chunk);
+        }
+
+        uint64_t size() const noexcept { return hash_.size(); }
+        const SessionParams& params() const noexcept { return params_; }
+        const SystemState& state() const noexcept { return state_; }
+
+    private:
+        friend class Keychain;
+
+        HashStream hash_;
+        NonceStream nonce_;
+        SessionParams params_;
+        SystemState state_;
+    };
+
     Key generate_key(
         std::span<const uint8_t> input,
         const SessionParams& params,
         const SystemState& state
     ) {
-        auto hash = HolographicHash::compute(input, params);
-        auto nonce = EmergentNonce::generate(input, state);
-        
-        std::array<uint8_t, 32> key{};
-        combine_hash_and_nonce(hash, nonce, key);
-        
-        auto key_obj = Key{key};
-        store_key(key_obj, params, state);
-        
-        return key_obj;
+        metrics::ScopedTimer timer(metrics::Op::generate_key, input.size());
+        auto key = derive_key(input, params, state);
+        store_key(key, params, state);
+        return key;
+    }
+
+    // Moves the context into the store instead of copying it
+    Key generate_key(
+        std::span<const uint8_t> input,
+        SessionParams&& params,
+        SystemState&& state
+    ) {
+        metrics::ScopedTimer timer(metrics::Op::generate_key, input.size());
+        auto key = derive_key(input, params, state);
+        store_key(key, std::move(params), std::move(state));
+        return key;
+    }
+
+    // Views and packed contexts; the store keeps an owning copy
+    Key generate_key(
+        std::span<const uint8_t> input,
+        const SessionView& params,
+        const StateView& state
+    ) {
+        metrics::ScopedTimer timer(metrics::Op::generate_key, input.size());
+        auto key = derive_key(input, params, state);
+        store_key(key, params.to_params(), state.to_state());
+        return key;
+    }
+
+    // As generate_key(), but failures are returned instead of thrown.
+    // Deriving the key never allocates; storing it allocates the map node
+    // and the owning copy of the context.
+    HashResult<Key> try_generate_key(
+        std::span<const uint8_t> input,
+        const SessionView& params,
+        const StateView& state
+    ) noexcept {
+        if (input.empty()) {
+            return ErrorCode::empty_input;
+        }
+        try {
+            return generate_key(input, params, state);
+        } catch (const std::bad_alloc&) {
+            return ErrorCode::out_of_memory;
+        } catch (...) {
+            return ErrorCode::key_store;
+        }
+    }
+
+    Key generate_key(const KeyStream& stream) {
+        metrics::ScopedTimer timer(metrics::Op::generate_key, stream.size());
+        auto key = derive_key(stream);
+        store_key(key, stream.params(), stream.state());
+        return key;
     }
     
+    // Generates a key for every (input, params, state) triple. Keys are
+    // derived on the pool, sixteen hashes per vector pass, and then inserted
+    // after a single reservation. Returns the keys in input order; if any
+    // derivation throws, nothing is inserted.
+    std::vector<Key> generate_keys(
+        std::span<const std::span<const uint8_t>> inputs,
+        std::span<const SessionParams> params,
+        std::span<const SystemState> states,
+        ThreadPool* pool = nullptr
+    ) {
+        return generate_keys_impl(inputs, params, states, pool);
+    }
+
+    std::vector<Key> generate_keys(
+        std::span<const std::span<const uint8_t>> inputs,
+        std::span<const SessionView> params,
+        std::span<const StateView> states,
+        ThreadPool* pool = nullptr
+    ) {
+        return generate_keys_impl(inputs, params, states, pool);
+    }
+
     bool validate_key(
         const Key& key,
-        const SessionParams& params,
-        const SystemState& state
-    ) {
-        auto it = key_store_.find(key);
-        if (it == key_store_.end()) {
-            return false;
+        const SessionView& params,
+        const StateView& state
+    ) const {
+        metrics::ScopedTimer timer(metrics::Op::validate_key);
+        const bool valid = check_key(key, params, state);
+        timer.fail(!valid);
+        return valid;
+    }
+
+    // Drops every key whose TTL has passed by now. Runs automatically on
+    // insertion; call it from a maintenance task to reclaim memory while
+    // the keychain is otherwise idle.
+    void expire(std::chrono::system_clock::time_point now = std::chrono::system_clock::now()) {
+        if (!expires()) {
+            return;
         }
-        
-        const auto& [stored_params, stored_state] = it->second;
-        return stored_params == params && stored_state == state;
+        wheel_.advance(to_tick(now), [this](Entry* entry) {
+            ++expirations_;
+            erase(entry);
+        });
+    }
+
+    KeychainStats stats() const noexcept {
+        return KeychainStats{key_store_.size(), bytes_, evictions_, expirations_};
     }
 
+    // Shape of the hash table; walks every bucket, so meant for periodic
+    // monitoring rather than the hot path
+    TableStats table_stats() const {
+        TableStats stats;
+        stats.keys = key_store_.size();
+        stats.buckets = key_store_.bucket_count();
+        stats.load_factor = key_store_.load_factor();
+        for (size_t b = 0; b < stats.buckets; ++b) {
+            const size_t chain = key_store_.bucket_size(b);
+            stats.empty_buckets += chain == 0;
+            stats.longest_chain = std::max(stats.longest_chain, chain);
+        }
+        return stats;
+    }
+
+    // Size and estimated false-positive rate of the key filter; all zero
+    // without one. Walks the filter, like table_stats().
+    FilterStats filter_stats() const noexcept {
+        return filter_.stats();
+    }
+
+    size_t size() const noexcept { return key_store_.size(); }
+    const KeychainOptions& options() const noexcept { return options_; }
+    AlgorithmVersion version() const noexcept { return options_.version; }
+    NonceMode nonce_mode() const noexcept { return options_.nonce_mode; }
+
 private:
+    friend class ConcurrentKeychain;
+    friend class FlatKeychain;
+
+    struct KeyData;
+    using Entry = std::pair<const Key, KeyData>;
+
     struct KeyData {
         SessionParams params;
         SystemState state;
+
+        std::chrono::system_clock::time_point expires_at{};
+        size_t bytes = 0;
+
+        // CLOCK ring and expiry wheel links
+        Entry* clock_prev = nullptr;
+        Entry* clock_next = nullptr;
+        mutable std::atomic<bool> referenced{false};
+        TimerHook<Entry> timer;
+
+        KeyData(SessionParams&& p, SystemState&& s) : params(std::move(p)), state(std::move(s)) {}
     };
-    
+
+    struct TimerOf {
+        TimerHook<Entry>& operator()(Entry* entry) const noexcept { return entry->second.timer; }
+    };
+
+    KeychainOptions options_;
+    std::chrono::system_clock::duration resolution_;
     std::unordered_map<Key, KeyData> key_store_;
+    TimerWheel<Entry, TimerOf> wheel_;
+    KeyFilter filter_;
+    Entry* clock_hand_ = nullptr;
+    size_t bytes_ = 0;
+    uint64_t evictions_ = 0;
+    uint64_t expirations_ = 0;
+
+    bool expires() const noexcept { return options_.ttl.count() > 0; }
 
-    static void combine_hash_and_nonce(
-        const Hash& hash,
-        const Nonce& nonce,
-        std::array<uint8_t, 32>& key
+    // Move body: adopts other's keys with the links into them and resets
+    // other, whose copies of those links would point into this keychain
+    void take(Keychain& other) noexcept {
+        key_store_ = std::move(other.key_store_);
+        other.key_store_.clear();
+        wheel_ = std::exchange(other.wheel_, TimerWheel<Entry, TimerOf>(other.wheel_.now()));
+        filter_ = std::exchange(other.filter_, KeyFilter{});
+        clock_hand_ = std::exchange(other.clock_hand_, nullptr);
+        bytes_ = std::exchange(other.bytes_, 0);
+        evictions_ = std::exchange(other.evictions_, 0);
+        expirations_ = std::exchange(other.expirations_, 0);
+    }
+
+    uint64_t to_tick(std::chrono::system_clock::time_point tp) const noexcept {
+        auto since_epoch = tp.time_since_epoch();
+        return since_epoch.count() <= 0 ? 0 : static_cast<uint64_t>(since_epoch / resolution_);
+    }
+
+    // Entry footprint: map node plus the heap blocks its context owns
+    static size_t entry_bytes(const SessionParams& params, const SystemState& state) noexcept {
+        auto heap = [](const auto& container) {
+            return container.capacity() * sizeof(typename std::decay_t<decltype(container)>::value_type);
+        };
+        return sizeof(Entry) + 2 * sizeof(void*) +
+               heap(params.source_ip) + heap(params.dest_ip) + heap(params.metadata) +
+               heap(state.content_hash) + heap(state.previous_nonce);
+    }
+
+    // validate_key() without metrics, for wrappers that time the call
+    bool check_key(
+        const Key& key,
+        const SessionView& params,
+        const StateView& state
+    ) const {
+        if (filter_.enabled() && !filter_.may_contain(key)) {
+            metrics::count(metrics::Op::key_filter, 1, 0);
+            return false;
+        }
+
+        auto it = key_store_.find(key);
+        if (it == key_store_.end()) {
+            if (filter_.enabled()) {
+                metrics::count(metrics::Op::key_filter, 1, 0, 1);
+            }
+            return false;
+        }
+
+        const auto& data = it->second;
+        if (expires() && std::chrono::system_clock::now() >= data.expires_at) {
+            return false;
+        }
+
+        // Second chance for the CLOCK sweep; relaxed since it is only a hint
+        data.referenced.store(true, std::memory_order_relaxed);
+        return SessionView(data.params) == params && StateView(data.state) == state;
+    }
+
+    // Key derivation without touching the store
+    Key derive_key(
+        std::span<const uint8_t> input,
+        const SessionView& params,
+        const StateView& state
+    ) const {
+        auto hash = HolographicHash::compute(input, params, options_.version);
+        auto nonce = EmergentNonce::generate(input, state, options_.version, options_.nonce_mode);
+
+        return combine_hash_and_nonce(hash, nonce);
+    }
+
+    template<typename Params, typename State>
+    std::vector<Key> generate_keys_impl(
+        std::span<const std::span<const uint8_t>> inputs,
+        std::span<const Params> params,
+        std::span<const State> states,
+        ThreadPool* pool
     ) {
+        auto keys = derive_keys(inputs, params, states, pool ? *pool : ThreadPool::shared());
+        if constexpr (metrics::enabled) {
+            uint64_t bytes = 0;
+            for (const auto& input : inputs) {
+                bytes += input.size();
+            }
+            metrics::count(metrics::Op::generate_key, inputs.size(), bytes);
+        }
+
+        size_t reserve = key_store_.size() + keys.size();
+        if (options_.max_keys != 0) {
+            reserve = std::min(reserve, options_.max_keys);
+        }
+        key_store_.reserve(reserve);
+        for (size_t i = 0; i < keys.size(); ++i) {
+            store_key(keys[i], SessionView(params[i]).to_params(), StateView(states[i]).to_state());
+        }
+        return keys;
+    }
+
+    // Batch derivation without touching the store. Each task covers one
+    // group of vector lanes, so compute_batch() keeps its lane parallelism.
+    template<typename Params, typename State>
+    std::vector<Key> derive_keys(
+        std::span<const std::span<const uint8_t>> inputs,
+        std::span<const Params> params,
+        std::span<const State> states,
+        ThreadPool& pool
+    ) const {
+        if (params.size() != inputs.size() || states.size() != inputs.size()) {
+            throw InvalidInputException("Batch inputs, params and states must have equal length");
+        }
+
+        constexpr size_t group = platform::ByteLanes16::lanes;
+        std::vector<Hash> hashes(inputs.size(), Hash{{}});
+        std::vector<Key> keys(inputs.size(), Key{{}});
+        pool.parallel_for((inputs.size() + group - 1) / group, [&](size_t g) {
+            const size_t begin = g * group;
+            const size_t count = std::min(group, inputs.size() - begin);
+
+            HolographicHash::compute_batch(inputs.subspan(begin, count), params.subspan(begin, count),
+                std::span<Hash>(hashes).subspan(begin, count), options_.version);
+            for (size_t i = 0; i < count; ++i) {
+                auto nonce = EmergentNonce::generate(inputs[begin + i], states[begin + i],
+                    options_.version, options_.nonce_mode);
+                keys[begin + i] = combine_hash_and_nonce(hashes[begin + i], nonce);
+            }
+        });
+        return keys;
+    }
+
+    static Key derive_key(const KeyStream& stream) {
+        if (stream.size() == 0) {
+            throw KeychainException("Key stream has no input");
+        }
+
+        return combine_hash_and_nonce(stream.hash_.finalize(), stream.nonce_.finalize());
+    }
+
+    bool over_budget(size_t extra_keys, size_t extra_bytes) const noexcept {
+        return (options_.max_keys != 0 && key_store_.size() + extra_keys > options_.max_keys) ||
+               (options_.max_bytes != 0 && bytes_ + extra_bytes > options_.max_bytes);
+    }
+
+    static Key combine_hash_and_nonce(const Hash& hash, const Nonce& nonce) {
         const auto& hash_data = hash.get();
         const auto& nonce_data = nonce.get();
         
         // Combine hash and nonce using XOR and rotation
-        for (size_t i = 0; i < key.size(); ++i) {
-            key[i] = hash_data[i] ^ nonce_data[i % nonce_data.size()];
-            key[i] = std::rotl(key[i], i % 8);
+        Key key{{}};
+        auto& key_data = key.get();
+        for (size_t i = 0; i < key_data.size(); ++i) {
+            key_data[i] = hash_data[i] ^ nonce_data[i % nonce_data.size()];
+            key_data[i] = std::rotl(key_data[i], i % 8);
+        }
+        return key;
+    }
+
+    // Takes the context by value so callers can move it in
+    void store_key(const Key& key, SessionParams params, SystemState state) {
+        auto expires_at = params.timestamp + options_.ttl;
+        if (expires()) {
+            auto now = std::chrono::system_clock::now();
+            expire(now);
+            if (now >= expires_at) {
+                ++expirations_;
+                return;
+            }
+        }
+
+        auto it = key_store_.find(key);
+        if (it != key_store_.end()) {
+            // Regenerated key: refresh its context in place
+            erase(&*it);
+        }
+
+        size_t bytes = entry_bytes(params, state);
+        while (!key_store_.empty() && over_budget(1, bytes)) {
+            evict_one();
+        }
+
+        auto [entry_it, inserted] = key_store_.try_emplace(key, std::move(params), std::move(state));
+        Entry* entry = &*entry_it;
+        entry->second.expires_at = expires_at;
+        entry->second.bytes = bytes;
+        bytes_ += bytes;
+
+        link_clock(entry);
+        if (expires()) {
+            // Round up so keys never expire early
+            auto deadline = to_tick(expires_at) + ((expires_at.time_since_epoch() % resolution_).count() != 0);
+            wheel_.schedule(entry, deadline);
+        }
+
+        if (filter_.enabled()) {
+            filter_.insert(key);
+            if (filter_.needs_rebuild()) {
+                rebuild_filter();
+            }
+        }
+    }
+
+    // Evicted, expired and refreshed keys leave their bits set; starting
+    // over from the live keys clears them
+    void rebuild_filter() {
+        filter_.reset(key_store_.size());
+        for (const auto& entry : key_store_) {
+            filter_.insert(entry.first);
+        }
+    }
+
+    // New entries go just behind the hand, i.e. they are swept last
+    void link_clock(Entry* entry) noexcept {
+        auto& data = entry->second;
+        if (!clock_hand_) {
+            data.clock_prev = data.clock_next = entry;
+            clock_hand_ = entry;
+            return;
+        }
+        Entry* tail = clock_hand_->second.clock_prev;
+        data.clock_prev = tail;
+        data.clock_next = clock_hand_;
+        tail->second.clock_next = entry;
+        clock_hand_->second.clock_prev = entry;
+    }
+
+    void unlink_clock(Entry* entry) noexcept {
+        auto& data = entry->second;
+        if (data.clock_next == entry) {
+            clock_hand_ = nullptr;
+        } else {
+            data.clock_prev->second.clock_next = data.clock_next;
+            data.clock_next->second.clock_prev = data.clock_prev;
+            if (clock_hand_ == entry) {
+                clock_hand_ = data.clock_next;
+            }
+        }
+        data.clock_prev = data.clock_next = nullptr;
+    }
+
+    // CLOCK: recently validated keys get a second chance, the first
+    // unreferenced key under the hand is evicted. Each referenced bit is
+    // cleared as the hand passes, so this is amortised O(1).
+    void evict_one() {
+        while (clock_hand_->second.referenced.exchange(false, std::memory_order_relaxed)) {
+            clock_hand_ = clock_hand_->second.clock_next;
         }
+        ++evictions_;
+        erase(clock_hand_);
     }
 
-    void store_key(const Key& key, const SessionParams& params, const SystemState& state) {
-        key_store_[key] = KeyData{params, state};
+    void erase(Entry* entry) {
+        wheel_.cancel(entry);
+        unlink_clock(entry);
+        bytes_ -= entry->second.bytes;
+        Key key = entry->first;
+        key_store_.erase(key);
     }
 };
 
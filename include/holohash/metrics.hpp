@@ -0,0 +1,389 @@
+#pragma once
+#include "platform.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <thread>
+#include <vector>
+
+// Hot-path metrics are compiled in only when HOLOHASH_METRICS is defined
+// (CMake option HOLOHASH_METRICS). Without it every recording call is an
+// empty inline function and snapshot() returns zeros.
+//
+// Each thread records into a block of its own: per-operation counters on
+// separate cache lines and a log-linear latency histogram per operation.
+// Only the owning thread writes a block, so recording is a few relaxed
+// loads and stores with no atomic read-modify-write; snapshot() sums the
+// blocks of all threads, past and present, on demand.
+
+namespace holohash {
+namespace metrics {
+
+#if defined(HOLOHASH_METRICS)
+inline constexpr bool enabled = true;
+#else
+inline constexpr bool enabled = false;
+#endif
+
+enum class Op : uint8_t {
+    hash,           // HolographicHash::compute and compute_batch
+    nonce,          // EmergentNonce::generate
+    generate_key,   // generate_key on every keychain
+    validate_key,   // validate_key on every keychain
+    key_filter,     // unknown keys checked by a Keychain key filter;
+                    // failures are the ones it let through
+};
+
+inline constexpr size_t op_count = 5;
+
+inline const char* op_name(Op op) noexcept {
+    switch (op) {
+        case Op::hash: return "hash";
+        case Op::nonce: return "nonce";
+        case Op::generate_key: return "generate_key";
+        case Op::validate_key: return "validate_key";
+        case Op::key_filter: return "key_filter";
+    }
+    return "unknown";
+}
+
+// Log-linear bucketing in the style of HdrHistogram: values below 16 get a
+// bucket each, and every power of two above is split into 16 linear
+// sub-buckets, so a bucket is within 1/16 of any value it holds
+struct Buckets {
+    static constexpr unsigned sub_bits = 4;
+    static constexpr size_t sub_count = size_t{1} << sub_bits;
+    static constexpr size_t count = (64 - sub_bits + 1) * sub_count;
+
+    static constexpr size_t index(uint64_t value) noexcept {
+        if (value < sub_count) {
+            return static_cast<size_t>(value);
+        }
+        const unsigned shift = static_cast<unsigned>(std::bit_width(value)) - 1 - sub_bits;
+        return (shift + 1) * sub_count + static_cast<size_t>((value >> shift) - sub_count);
+    }
+
+    // Smallest value in bucket i
+    static constexpr uint64_t lower(size_t i) noexcept {
+        if (i < sub_count) {
+            return i;
+        }
+        const size_t shift = i / sub_count - 1;
+        return (sub_count + i % sub_count) << shift;
+    }
+
+    // Largest value in bucket i
+    static constexpr uint64_t upper(size_t i) noexcept {
+        return i + 1 < count ? lower(i + 1) - 1 : UINT64_MAX;
+    }
+};
+
+static_assert(Buckets::index(15) == 15 && Buckets::index(16) == 16 && Buckets::index(33) == 32);
+static_assert(Buckets::lower(Buckets::index(1000)) <= 1000 && Buckets::upper(Buckets::index(1000)) >= 1000);
+static_assert(Buckets::index(UINT64_MAX) == Buckets::count - 1);
+
+// Aggregated latency distribution of one operation, in nanoseconds
+class Histogram {
+public:
+    Histogram() : counts_(Buckets::count, 0) {}
+
+    void record(uint64_t ns, uint64_t times = 1) {
+        counts_[Buckets::index(ns)] += times;
+        total_ += times;
+        max_ = std::max(max_, ns);
+    }
+
+    uint64_t count() const noexcept { return total_; }
+    uint64_t max() const noexcept { return max_; }
+
+    // Value at percentile p (0-100), reported as the middle of its bucket
+    double percentile(double p) const noexcept {
+        if (total_ == 0) {
+            return 0;
+        }
+        const double target = std::max(1.0, p / 100.0 * static_cast<double>(total_));
+        uint64_t seen = 0;
+        for (size_t i = 0; i < counts_.size(); ++i) {
+            seen += counts_[i];
+            if (static_cast<double>(seen) >= target) {
+                const double mid = (static_cast<double>(Buckets::lower(i)) + static_cast<double>(Buckets::upper(i))) / 2;
+                return std::min(mid, static_cast<double>(max_));
+            }
+        }
+        return static_cast<double>(max_);
+    }
+
+    double mean() const noexcept {
+        if (total_ == 0) {
+            return 0;
+        }
+        double sum = 0;
+        for (size_t i = 0; i < counts_.size(); ++i) {
+            if (counts_[i] != 0) {
+                sum += counts_[i] * (static_cast<double>(Buckets::lower(i)) + static_cast<double>(Buckets::upper(i))) / 2;
+            }
+        }
+        return std::min(sum / total_, static_cast<double>(max_));
+    }
+
+    const std::vector<uint64_t>& buckets() const noexcept { return counts_; }
+
+    Histogram& operator+=(const Histogram& other) {
+        for (size_t i = 0; i < counts_.size(); ++i) {
+            counts_[i] += other.counts_[i];
+        }
+        total_ += other.total_;
+        max_ = std::max(max_, other.max_);
+        return *this;
+    }
+
+    // Records made between earlier and this; max stays that of this
+    Histogram& operator-=(const Histogram& earlier) {
+        for (size_t i = 0; i < counts_.size(); ++i) {
+            counts_[i] -= earlier.counts_[i];
+        }
+        total_ -= earlier.total_;
+        return *this;
+    }
+
+private:
+    std::vector<uint64_t> counts_;
+    uint64_t total_ = 0;
+    uint64_t max_ = 0;
+};
+
+struct OpStats {
+    uint64_t calls = 0;
+    uint64_t bytes = 0;         // input bytes processed
+    uint64_t failures = 0;      // validate_key: keys rejected; key_filter: false positives
+    Histogram latency;          // timed calls only; batches are counted, not timed
+};
+
+// Totals over all threads at one point in time. Subtracting an earlier
+// snapshot gives the activity in between, e.g. calls per second.
+struct Snapshot {
+    std::array<OpStats, op_count> ops;
+    std::chrono::steady_clock::time_point taken;
+
+    const OpStats& operator[](Op op) const noexcept { return ops[static_cast<size_t>(op)]; }
+    OpStats& operator[](Op op) noexcept { return ops[static_cast<size_t>(op)]; }
+
+    Snapshot& operator-=(const Snapshot& earlier) {
+        for (size_t i = 0; i < op_count; ++i) {
+            ops[i].calls -= earlier.ops[i].calls;
+            ops[i].bytes -= earlier.ops[i].bytes;
+            ops[i].failures -= earlier.ops[i].failures;
+            ops[i].latency -= earlier.ops[i].latency;
+        }
+        return *this;
+    }
+
+    friend Snapshot operator-(Snapshot later, const Snapshot& earlier) {
+        later -= earlier;
+        return later;
+    }
+};
+
+namespace detail {
+
+// Raw timestamps: the time stamp counter on x86-64, which is far cheaper to
+// read than the system clock, otherwise steady_clock nanoseconds
+inline uint64_t ticks() noexcept {
+#if defined(HOLOHASH_ARCH_X64)
+    return __rdtsc();
+#else
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+// Calibrated once against steady_clock, on first use
+inline double ns_per_tick() {
+#if defined(HOLOHASH_ARCH_X64)
+    static const double ratio = [] {
+        const auto t0 = std::chrono::steady_clock::now();
+        const uint64_t c0 = ticks();
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        const uint64_t c1 = ticks();
+        const auto t1 = std::chrono::steady_clock::now();
+        const double ns = std::chrono::duration<double, std::nano>(t1 - t0).count();
+        return c1 > c0 ? ns / static_cast<double>(c1 - c0) : 1.0;
+    }();
+    return ratio;
+#else
+    return 1.0;
+#endif
+}
+
+// Single-writer counter: the owning thread adds with a plain load and
+// store, snapshot() reads it from any thread
+struct Counter {
+    std::atomic<uint64_t> value{0};
+
+    void add(uint64_t n) noexcept {
+        value.store(value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+    uint64_t get() const noexcept { return value.load(std::memory_order_relaxed); }
+};
+
+struct alignas(platform::get_cache_line_size()) OpBlock {
+    Counter calls;
+    Counter bytes;
+    Counter failures;
+    std::array<Counter, Buckets::count> latency;     // in ticks
+};
+
+struct ThreadBlock {
+    std::array<OpBlock, op_count> ops;
+    bool in_use = true;
+};
+
+// Owns every thread's block. Blocks outlive their threads, so counts are
+// never lost, and are handed to later threads for reuse.
+class Registry {
+public:
+    static Registry& instance() {
+        static Registry registry;
+        return registry;
+    }
+
+    ThreadBlock* acquire() {
+        std::lock_guard lock(mutex_);
+        for (auto& block : blocks_) {
+            if (!block->in_use) {
+                block->in_use = true;
+                return block.get();
+            }
+        }
+        blocks_.push_back(std::make_unique<ThreadBlock>());
+        return blocks_.back().get();
+    }
+
+    void release(ThreadBlock* block) {
+        std::lock_guard lock(mutex_);
+        block->in_use = false;
+    }
+
+    template<typename Fn>
+    void for_each(Fn&& fn) {
+        std::lock_guard lock(mutex_);
+        for (const auto& block : blocks_) {
+            fn(*block);
+        }
+    }
+
+private:
+    std::mutex mutex_;
+    std::vector<std::unique_ptr<ThreadBlock>> blocks_;
+};
+
+inline OpBlock& local(Op op) {
+    struct Slot {
+        ThreadBlock* block = Registry::instance().acquire();
+        ~Slot() { Registry::instance().release(block); }
+    };
+    thread_local Slot slot;
+    return slot.block->ops[static_cast<size_t>(op)];
+}
+
+} // namespace detail
+
+// Counts calls, bytes and failures without timing them, for batch entry
+// points and untimed checks
+inline void count([[maybe_unused]] Op op, [[maybe_unused]] uint64_t calls, [[maybe_unused]] uint64_t bytes,
+                  [[maybe_unused]] uint64_t failures = 0) noexcept {
+#if defined(HOLOHASH_METRICS)
+    auto& block = detail::local(op);
+    block.calls.add(calls);
+    block.bytes.add(bytes);
+    block.failures.add(failures);
+#endif
+}
+
+// Times its own lifetime and records one call of op
+class ScopedTimer {
+public:
+#if defined(HOLOHASH_METRICS)
+    explicit ScopedTimer(Op op, uint64_t bytes = 0) noexcept
+        : block_(detail::local(op)), bytes_(bytes), start_(detail::ticks()) {}
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+    ~ScopedTimer() {
+        const uint64_t elapsed = detail::ticks() - start_;
+        block_.calls.add(1);
+        block_.bytes.add(bytes_);
+        block_.failures.add(failed_);
+        block_.latency[Buckets::index(elapsed)].add(1);
+    }
+
+    // Counts the call as a failure, e.g. a rejected key
+    void fail(bool failed = true) noexcept { failed_ = failed; }
+
+private:
+    detail::OpBlock& block_;
+    uint64_t bytes_;
+    uint64_t start_;
+    bool failed_ = false;
+#else
+    explicit ScopedTimer(Op, uint64_t = 0) noexcept {}
+    void fail(bool = true) noexcept {}
+#endif
+};
+
+// Sums the blocks of every thread. Counters are read one by one while
+// other threads keep recording, so the totals are not an atomic cut.
+inline Snapshot snapshot() {
+    Snapshot result;
+    result.taken = std::chrono::steady_clock::now();
+#if defined(HOLOHASH_METRICS)
+    const double scale = detail::ns_per_tick();
+    detail::Registry::instance().for_each([&](const detail::ThreadBlock& block) {
+        for (size_t i = 0; i < op_count; ++i) {
+            const auto& op = block.ops[i];
+            auto& out = result.ops[i];
+            out.calls += op.calls.get();
+            out.bytes += op.bytes.get();
+            out.failures += op.failures.get();
+            for (size_t b = 0; b < Buckets::count; ++b) {
+                if (uint64_t n = op.latency[b].get()) {
+                    // Bucket midpoint in ticks, converted to nanoseconds
+                    const double ticks = (static_cast<double>(Buckets::lower(b)) + static_cast<double>(Buckets::upper(b))) / 2;
+                    out.latency.record(static_cast<uint64_t>(ticks * scale), n);
+                }
+            }
+        }
+    });
+#endif
+    return result;
+}
+
+// One JSON object with per-operation counts and latency percentiles
+inline void write_json(std::ostream& out, const Snapshot& snapshot) {
+    out << "{";
+    for (size_t i = 0; i < op_count; ++i) {
+        const auto& op = snapshot.ops[i];
+        out << (i == 0 ? "" : ", ") << "\"" << op_name(static_cast<Op>(i)) << "\": {"
+            << "\"calls\": " << op.calls
+            << ", \"bytes\": " << op.bytes
+            << ", \"failures\": " << op.failures
+            << ", \"timed\": " << op.latency.count()
+            << ", \"mean_ns\": " << op.latency.mean()
+            << ", \"p50_ns\": " << op.latency.percentile(50)
+            << ", \"p90_ns\": " << op.latency.percentile(90)
+            << ", \"p99_ns\": " << op.latency.percentile(99)
+            << ", \"p999_ns\": " << op.latency.percentile(99.9)
+            << ", \"max_ns\": " << op.latency.max() << "}";
+    }
+    out << "}\n";
+}
+
+} // namespace metrics
+} // namespace holohash
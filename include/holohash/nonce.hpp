@@ -1,36 +1,155 @@
 #pragma once
 #include "types.hpp"
 #include "exceptions.hpp"
+#include "result.hpp"
 #include "platform.hpp"
+#include "generator.hpp"
+#include "metrics.hpp"
 #include <random>
 #include <functional>
+#include <algorithm>
+#include <span>
+#include <bit>
+#include <string>
+#include <string_view>
 
 namespace holohash {
 
+// How the input is folded into the nonce. recursive is the original
+// transform that revisits every input byte for each nonce byte (16 x N
+// draws). linear reads the input once in 16-byte blocks and is what
+// NonceStream computes; it is the same for every AlgorithmVersion.
+enum class NonceMode : uint8_t {
+    recursive,
+    linear
+};
+
 class EmergentNonce {
 public:
-    static Nonce generate(std::span<const uint8_t> input, const SystemState& state) {
+    static Nonce generate(
+        std::span<const uint8_t> input,
+        const StateView& state,
+        AlgorithmVersion version = AlgorithmVersion::v1,
+        NonceMode mode = NonceMode::recursive
+    ) {
         if (input.empty()) {
             throw NonceGenerationException("Input data cannot be empty");
         }
+        return generate_unchecked(input, state, version, mode);
+    }
+
+    // As generate(), but failures are returned instead of thrown. Neither
+    // variant allocates.
+    static HashResult<Nonce> try_generate(
+        std::span<const uint8_t> input,
+        const StateView& state,
+        AlgorithmVersion version = AlgorithmVersion::v1,
+        NonceMode mode = NonceMode::recursive
+    ) noexcept {
+        if (input.empty()) {
+            return ErrorCode::empty_input;
+        }
+        return generate_unchecked(input, state, version, mode);
+    }
+
+private:
+    friend class NonceStream;
+
+    static Nonce generate_unchecked(
+        std::span<const uint8_t> input,
+        const StateView& state,
+        AlgorithmVersion version,
+        NonceMode mode
+    ) noexcept {
+        metrics::ScopedTimer timer(metrics::Op::nonce, input.size());
 
         std::array<uint8_t, 16> nonce{};
         
         // Mix system state into nonce
         mix_system_state(state, nonce);
         
-        // Apply recursive transformation
-        apply_recursive_transform(input, state.previous_nonce, nonce);
+        // Fold the input into the nonce
+        if (mode == NonceMode::linear) {
+            chain_previous_nonce(state.previous_nonce, nonce);
+
+            LinearState acc = linear_init(nonce);
+            size_t full = input.size() & ~(linear_block_size - 1);
+            linear_absorb(acc, input.data(), full);
+            nonce = linear_finish(acc, input.subspan(full), input.size(), nonce);
+        } else if (version == AlgorithmVersion::v1) {
+            apply_recursive_transform(input, state.previous_nonce, nonce);
+        } else {
+            apply_recursive_transform_v2(input, state.previous_nonce, nonce);
+        }
         
         return Nonce{nonce};
     }
 
-private:
-    static void mix_system_state(const SystemState& state, std::array<uint8_t, 16>& nonce) {
+    static constexpr size_t linear_block_size = 16;
+
+    // Two independent 64-bit lanes, one per half of each 16-byte block
+    struct LinearState {
+        uint64_t a;
+        uint64_t b;
+    };
+
+    static void chain_previous_nonce(std::span<const uint8_t> previous_nonce, std::array<uint8_t, 16>& nonce) {
+        if (!previous_nonce.empty()) {
+            platform::simd_xor_block(nonce.data(), previous_nonce.data(),
+                std::min(previous_nonce.size(), nonce.size()));
+        }
+    }
+
+    static LinearState linear_init(const std::array<uint8_t, 16>& seed) noexcept {
+        return {detail::load_le64(seed.data()), detail::load_le64(seed.data() + 8)};
+    }
+
+    // Absorbs len bytes (a multiple of linear_block_size) with one 64-bit
+    // load, XOR, rotate and odd multiply per lane and block
+    static void linear_absorb(LinearState& acc, const uint8_t* data, size_t len) noexcept {
+        uint64_t a = acc.a;
+        uint64_t b = acc.b;
+        for (size_t i = 0; i < len; i += linear_block_size) {
+            a = std::rotl(a ^ detail::load_le64(data + i), 29) * 0x9E3779B97F4A7C15ULL;
+            b = std::rotl(b ^ detail::load_le64(data + i + 8), 31) * 0xC2B2AE3D27D4EB4FULL;
+        }
+        acc = {a, b};
+    }
+
+    // Absorbs the zero-padded tail, then the total length as a block of its
+    // own, so padding cannot be confused with data bytes; cross-mixes the
+    // lanes and whitens the result with the seed
+    static std::array<uint8_t, 16> linear_finish(
+        LinearState acc,
+        std::span<const uint8_t> tail,
+        uint64_t total_size,
+        const std::array<uint8_t, 16>& seed
+    ) noexcept {
+        std::array<uint8_t, linear_block_size> last{};
+        std::copy(tail.begin(), tail.end(), last.begin());
+        linear_absorb(acc, last.data(), last.size());
+
+        std::array<uint8_t, linear_block_size> length{};
+        for (size_t i = 0; i < 8; ++i) {
+            length[i] = static_cast<uint8_t>(total_size >> (i * 8));
+        }
+        linear_absorb(acc, length.data(), length.size());
+
+        uint64_t lo = detail::mix64(acc.a ^ std::rotl(acc.b, 32));
+        uint64_t hi = detail::mix64(acc.b + lo);
+
+        std::array<uint8_t, 16> nonce{};
+        for (size_t i = 0; i < 8; ++i) {
+            nonce[i] = static_cast<uint8_t>(lo >> (i * 8)) ^ seed[i];
+            nonce[8 + i] = static_cast<uint8_t>(hi >> (i * 8)) ^ seed[8 + i];
+        }
+        return nonce;
+    }
+
+    static void mix_system_state(const StateView& state, std::array<uint8_t, 16>& nonce) {
         // Mix content hash using SIMD
         if (!state.content_hash.empty()) {
-            platform::simd_xor_block(nonce.data(), 
-                reinterpret_cast<const uint8_t*>(state.content_hash.data()),
+            platform::simd_xor_block(nonce.data(), state.content_hash.data(),
                 std::min(state.content_hash.size(), size_t{8}));
         }
 
@@ -52,7 +171,10 @@ private:
         std::span<const uint8_t> previous_nonce,
         std::array<uint8_t, 16>& nonce
     ) {
-        std::mt19937 rng(std::hash<std::string>{}(std::string(input.begin(), input.end())));
+        // std::hash<std::string_view> equals std::hash<std::string> for the
+        // same characters, without copying the input into a string
+        std::mt19937 rng(static_cast<std::mt19937::result_type>(std::hash<std::string_view>{}(
+            std::string_view(reinterpret_cast<const char*>(input.data()), input.size()))));
         
         // Apply recursive transformation using SIMD when possible
         if (!previous_nonce.empty()) {
@@ -77,6 +199,200 @@ private:
             platform::simd_xor_block(nonce.data() + i, temp.data(), chunk_size);
         }
     }
+
+    // Same walk as apply_recursive_transform(), but seeded from a portable
+    // digest of the input and drawing offsets from a CounterGenerator with
+    // multiply-shift reduction, so results are identical on every host.
+    static void apply_recursive_transform_v2(
+        std::span<const uint8_t> input,
+        std::span<const uint8_t> previous_nonce,
+        std::array<uint8_t, 16>& nonce
+    ) {
+        CounterGenerator next_offset(digest64(input));
+
+        if (!previous_nonce.empty()) {
+            platform::simd_xor_block(nonce.data(), previous_nonce.data(),
+                std::min(previous_nonce.size(), nonce.size()));
+        }
+
+        std::array<uint8_t, 16> temp{};
+        for (size_t j = 0; j < temp.size(); ++j) {
+            for (size_t k = 0; k < input.size(); ++k) {
+                size_t idx = k + next_offset(input.size());
+                if (idx >= input.size()) {
+                    idx -= input.size();
+                }
+                temp[j] ^= input[idx];
+            }
+            temp[j] = platform::rotate_left(temp[j], 3);
+        }
+
+        platform::simd_xor_block(nonce.data(), temp.data(), temp.size());
+    }
+};
+
+// Incremental nonce generator matching HashStream. It runs the linear
+// nonce kernel, so only the current partial 16-byte block is retained and
+// the result equals EmergentNonce::generate() with NonceMode::linear for
+// the concatenated input.
+class NonceStream {
+public:
+    static constexpr size_t block_size = EmergentNonce::linear_block_size;
+
+    explicit NonceStream(const StateView& state) {
+        EmergentNonce::mix_system_state(state, seed_);
+        EmergentNonce::chain_previous_nonce(state.previous_nonce, seed_);
+        acc_ = EmergentNonce::linear_init(seed_);
+    }
+
+    void update(std::span<const uint8_t> chunk) {
+        total_size_ += chunk.size();
+
+        if (buffered_ > 0) {
+            size_t take = std::min(chunk.size(), block_size - buffered_);
+            std::copy_n(chunk.begin(), take, buffer_.begin() + buffered_);
+            buffered_ += take;
+            chunk = chunk.subspan(take);
+            if (buffered_ < block_size) {
+                return;
+            }
+            EmergentNonce::linear_absorb(acc_, buffer_.data(), block_size);
+            buffered_ = 0;
+        }
+
+        size_t full = chunk.size() & ~(block_size - 1);
+        EmergentNonce::linear_absorb(acc_, chunk.data(), full);
+        chunk = chunk.subspan(full);
+
+        std::copy(chunk.begin(), chunk.end(), buffer_.begin());
+        buffered_ = chunk.size();
+    }
+
+    // Produces the nonce for everything absorbed so far without consuming
+    // the stream.
+    Nonce finalize() const {
+        if (total_size_ == 0) {
+            throw NonceGenerationException("Input data cannot be empty");
+        }
+
+        return Nonce{EmergentNonce::linear_finish(acc_,
+            std::span<const uint8_t>(buffer_.data(), buffered_), total_size_, seed_)};
+    }
+
+    uint64_t size() const noexcept { return total_size_; }
+
+private:
+    std::array<uint8_t, 16> seed_{};
+    EmergentNonce::LinearState acc_{};
+    std::array<uint8_t, block_size> buffer_{};
+    size_t buffered_ = 0;
+    uint64_t total_size_ = 0;
+};
+
+// A chain of nonces, each generated with the previous one as its
+// previous_nonce. The head and the last `history` links are kept inline in
+// a ring, so advancing allocates nothing beyond what the nonce kernel itself
+// needs, and rolling back within the ring is O(1) instead of a replay from
+// the start. Link n is
+//
+//   EmergentNonce::generate(input_n, state_n with previous_nonce = link n-1)
+//
+// where link 0 is the seed; a zero seed is the same as no previous nonce.
+class NonceChain {
+public:
+    static constexpr size_t history = 64;
+
+    // A chain position together with its head, enough to restore it
+    struct Checkpoint {
+        uint64_t position;
+        std::array<uint8_t, 16> head;
+
+        bool operator==(const Checkpoint&) const = default;
+    };
+
+    explicit NonceChain(
+        AlgorithmVersion version = AlgorithmVersion::v1,
+        NonceMode mode = NonceMode::recursive
+    ) noexcept : version_(version), mode_(mode) {}
+
+    NonceChain(
+        const Nonce& seed,
+        AlgorithmVersion version = AlgorithmVersion::v1,
+        NonceMode mode = NonceMode::recursive
+    ) noexcept : seed_(seed.get()), version_(version), mode_(mode) {}
+
+    // Appends a link. state.previous_nonce is ignored in favour of the head.
+    Nonce next(std::span<const uint8_t> input, const StateView& state) {
+        StateView linked = state;
+        linked.previous_nonce = head_bytes();
+        Nonce nonce = EmergentNonce::generate(input, linked, version_, mode_);
+
+        ++position_;
+        ring_[position_ % history] = nonce.get();
+        oldest_ = std::max(oldest_, position_ >= history ? position_ - history + 1 : uint64_t{1});
+        return nonce;
+    }
+
+    Nonce head() const noexcept { return Nonce{head_bytes()}; }
+    uint64_t position() const noexcept { return position_; }
+    AlgorithmVersion version() const noexcept { return version_; }
+    NonceMode mode() const noexcept { return mode_; }
+
+    // Whether rewind(position) can succeed: the seed and the links still
+    // in the ring are reachable
+    bool can_rewind(uint64_t position) const noexcept {
+        return position == 0 || (position >= oldest_ && position <= position_);
+    }
+
+    // Moves the head back to an earlier link; later links are discarded
+    void rewind(uint64_t position) {
+        if (!can_rewind(position)) {
+            throw NonceGenerationException("Nonce chain position " + std::to_string(position) +
+                                           " is outside the rollback history");
+        }
+        position_ = position;
+    }
+
+    void rollback(uint64_t links) {
+        if (links > position_) {
+            throw NonceGenerationException("Cannot roll back past the start of the nonce chain");
+        }
+        rewind(position_ - links);
+    }
+
+    Checkpoint checkpoint() const noexcept { return {position_, head_bytes()}; }
+
+    // Restores a checkpoint of this chain. A checkpoint whose link is no
+    // longer in the ring, or was overwritten by a different branch, is
+    // restored from its stored head; earlier links are then unreachable
+    // until the chain advances again.
+    void restore(const Checkpoint& checkpoint) noexcept {
+        if (can_rewind(checkpoint.position) && head_at(checkpoint.position) == checkpoint.head) {
+            position_ = checkpoint.position;
+            return;
+        }
+        position_ = checkpoint.position;
+        if (position_ == 0) {
+            seed_ = checkpoint.head;
+        } else {
+            ring_[position_ % history] = checkpoint.head;
+        }
+        oldest_ = std::max<uint64_t>(position_, 1);
+    }
+
+private:
+    std::array<uint8_t, 16> seed_{};
+    std::array<std::array<uint8_t, 16>, history> ring_{};   // link n at n % history
+    uint64_t position_ = 0;
+    uint64_t oldest_ = 1;   // oldest link still in the ring
+    AlgorithmVersion version_;
+    NonceMode mode_;
+
+    const std::array<uint8_t, 16>& head_at(uint64_t position) const noexcept {
+        return position == 0 ? seed_ : ring_[position % history];
+    }
+
+    const std::array<uint8_t, 16>& head_bytes() const noexcept { return head_at(position_); }
 };
 
 } // namespace holohash
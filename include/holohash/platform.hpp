@@ -1,9 +1,36 @@
 #pragma once
 #include <cstdint>
 #include <cstddef>
+#include <cerrno>
+#include <algorithm>
 #include <type_traits>
 #include <bit>
 #include <array>
+#include <atomic>
+#include <cstring>
+#include <new>
+#include <utility>
+#include "cpu.hpp"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <immintrin.h>
+#endif
+
+#if defined(__linux__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include <fstream>
+#endif
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define HOLOHASH_HAVE_IO_URING
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#endif
 
 namespace holohash {
 namespace platform {
@@ -62,26 +89,853 @@ constexpr uint8_t rotate_left(uint8_t value, unsigned int count) noexcept {
     return static_cast<uint8_t>((value << count) | (value >> ((-count) & mask)));
 }
 
-// Simple block operations
-inline void simd_xor_block(uint8_t* dst, const uint8_t* src, size_t len) noexcept {
-    // Process data in 8-byte chunks for better performance
-    size_t chunks = len / 8;
-    for (size_t i = 0; i < chunks; ++i) {
-        uint64_t* dst64 = reinterpret_cast<uint64_t*>(dst + i * 8);
-        const uint64_t* src64 = reinterpret_cast<const uint64_t*>(src + i * 8);
-        *dst64 ^= *src64;
+// Sixteen independent byte lanes processed in lock-step. The multi-buffer
+// kernels keep byte j of sixteen different hash states in one of these, so
+// every operation below acts on all lanes at once.
+struct ByteLanes16 {
+    static constexpr size_t lanes = 16;
+
+#if defined(HOLOHASH_ARCH_X64)
+    __m128i v;
+
+    static ByteLanes16 load(const uint8_t* src) noexcept {
+        return {_mm_loadu_si128(reinterpret_cast<const __m128i*>(src))};
     }
-    
-    // Handle remaining bytes
-    for (size_t i = chunks * 8; i < len; ++i) {
-        dst[i] ^= src[i];
+
+    void store(uint8_t* dst) const noexcept {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), v);
     }
-}
+
+    friend ByteLanes16 operator^(ByteLanes16 a, ByteLanes16 b) noexcept {
+        return {_mm_xor_si128(a.v, b.v)};
+    }
+
+    friend ByteLanes16 operator+(ByteLanes16 a, ByteLanes16 b) noexcept {
+        return {_mm_add_epi8(a.v, b.v)};
+    }
+
+    // SSE2 has no 8-bit shifts, so shift 16-bit words and mask off the bits
+    // that crossed into the neighbouring byte
+    template<unsigned Count>
+    ByteLanes16 rotl() const noexcept {
+        static_assert(Count > 0 && Count < 8, "Rotation count must be 1..7");
+        const __m128i hi_mask = _mm_set1_epi8(static_cast<char>(0xFFu << Count));
+        const __m128i lo_mask = _mm_set1_epi8(static_cast<char>(0xFFu >> (8 - Count)));
+        return {_mm_or_si128(
+            _mm_and_si128(_mm_slli_epi16(v, Count), hi_mask),
+            _mm_and_si128(_mm_srli_epi16(v, 8 - Count), lo_mask))};
+    }
+#else
+    std::array<uint8_t, lanes> v;
+
+    static ByteLanes16 load(const uint8_t* src) noexcept {
+        ByteLanes16 r;
+        for (size_t i = 0; i < lanes; ++i) r.v[i] = src[i];
+        return r;
+    }
+
+    void store(uint8_t* dst) const noexcept {
+        for (size_t i = 0; i < lanes; ++i) dst[i] = v[i];
+    }
+
+    friend ByteLanes16 operator^(ByteLanes16 a, ByteLanes16 b) noexcept {
+        for (size_t i = 0; i < lanes; ++i) a.v[i] ^= b.v[i];
+        return a;
+    }
+
+    friend ByteLanes16 operator+(ByteLanes16 a, ByteLanes16 b) noexcept {
+        for (size_t i = 0; i < lanes; ++i) a.v[i] = static_cast<uint8_t>(a.v[i] + b.v[i]);
+        return a;
+    }
+
+    template<unsigned Count>
+    ByteLanes16 rotl() const noexcept {
+        static_assert(Count > 0 && Count < 8, "Rotation count must be 1..7");
+        ByteLanes16 r;
+        for (size_t i = 0; i < lanes; ++i) r.v[i] = rotate_left(v[i], Count);
+        return r;
+    }
+#endif
+};
 
 // Cache line size detection
 constexpr size_t get_cache_line_size() noexcept {
     return 64; // Most modern processors use 64-byte cache lines
 }
 
+constexpr size_t get_huge_page_size() noexcept {
+    return size_t{2} << 20;
+}
+
+// Zero-filled, cache-line aligned slab for large tables. On POSIX systems
+// it is mapped straight from the kernel so untouched pages cost nothing.
+// With huge_pages, Linux first tries explicit MAP_HUGETLB pages and falls
+// back to asking for transparent huge pages, which cuts TLB misses on
+// random lookups over gigabyte-sized tables; huge() reports which was used.
+class PageBuffer {
+public:
+    PageBuffer() noexcept = default;
+
+    PageBuffer(size_t bytes, bool huge_pages) {
+        if (bytes == 0) {
+            return;
+        }
+#if defined(__linux__) || defined(__APPLE__)
+    #if defined(MAP_HUGETLB)
+        if (huge_pages && bytes >= get_huge_page_size()) {
+            size_t rounded = (bytes + get_huge_page_size() - 1) & ~(get_huge_page_size() - 1);
+            void* p = ::mmap(nullptr, rounded, PROT_READ | PROT_WRITE,
+                             MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if (p != MAP_FAILED) {
+                data_ = static_cast<uint8_t*>(p);
+                size_ = rounded;
+                huge_ = true;
+                return;
+            }
+        }
+    #endif
+        void* p = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED) {
+            throw std::bad_alloc();
+        }
+    #if defined(MADV_HUGEPAGE)
+        if (huge_pages) {
+            ::madvise(p, bytes, MADV_HUGEPAGE);
+        }
+    #endif
+        data_ = static_cast<uint8_t*>(p);
+        size_ = bytes;
+#else
+        (void)huge_pages;
+        data_ = static_cast<uint8_t*>(::operator new(bytes, std::align_val_t{get_cache_line_size()}));
+        std::memset(data_, 0, bytes);
+        size_ = bytes;
+#endif
+    }
+
+    PageBuffer(PageBuffer&& other) noexcept
+        : data_(std::exchange(other.data_, nullptr)),
+          size_(std::exchange(other.size_, 0)),
+          huge_(std::exchange(other.huge_, false)) {}
+
+    PageBuffer& operator=(PageBuffer&& other) noexcept {
+        if (this != &other) {
+            release();
+            data_ = std::exchange(other.data_, nullptr);
+            size_ = std::exchange(other.size_, 0);
+            huge_ = std::exchange(other.huge_, false);
+        }
+        return *this;
+    }
+
+    PageBuffer(const PageBuffer&) = delete;
+    PageBuffer& operator=(const PageBuffer&) = delete;
+
+    ~PageBuffer() { release(); }
+
+    uint8_t* data() const noexcept { return data_; }
+    size_t size() const noexcept { return size_; }
+    bool huge() const noexcept { return huge_; }
+
+private:
+    uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+    bool huge_ = false;
+
+    void release() noexcept {
+        if (!data_) {
+            return;
+        }
+#if defined(__linux__) || defined(__APPLE__)
+        ::munmap(data_, size_);
+#else
+        ::operator delete(data_, std::align_val_t{get_cache_line_size()});
+#endif
+        data_ = nullptr;
+    }
+};
+
+// Read-only view of a whole file. On POSIX systems the file is mapped, so
+// opening is O(1) and pages are read as they are touched; the access hint
+// tunes kernel readahead for the expected pattern. Elsewhere the file is
+// read into a PageBuffer. Empty files give an empty view.
+class MappedFile {
+public:
+    enum class Access : uint8_t {
+        normal,
+        sequential,
+        random
+    };
+
+    MappedFile() noexcept = default;
+
+    // False if the file cannot be opened or mapped
+    bool open(const char* path, Access access = Access::normal) noexcept {
+        close();
+#if defined(__linux__) || defined(__APPLE__)
+        int fd = ::open(path, O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat info;
+        if (::fstat(fd, &info) != 0) {
+            ::close(fd);
+            return false;
+        }
+        size_ = static_cast<size_t>(info.st_size);
+        if (size_ == 0) {
+            ::close(fd);
+            return true;
+        }
+        void* p = ::mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (p == MAP_FAILED) {
+            size_ = 0;
+            return false;
+        }
+        if (access != Access::normal) {
+            ::madvise(p, size_, access == Access::sequential ? MADV_SEQUENTIAL : MADV_RANDOM);
+        }
+        data_ = static_cast<const uint8_t*>(p);
+        return true;
+#else
+        (void)access;
+        std::ifstream in(path, std::ios::binary | std::ios::ate);
+        if (!in) {
+            return false;
+        }
+        size_ = static_cast<size_t>(in.tellg());
+        in.seekg(0);
+        buffer_ = PageBuffer(size_, false);
+        if (size_ != 0 && !in.read(reinterpret_cast<char*>(buffer_.data()), static_cast<std::streamsize>(size_))) {
+            buffer_ = PageBuffer();
+            size_ = 0;
+            return false;
+        }
+        data_ = buffer_.data();
+        return true;
+#endif
+    }
+
+    MappedFile(MappedFile&& other) noexcept
+        : data_(std::exchange(other.data_, nullptr)),
+          size_(std::exchange(other.size_, 0))
+#if !defined(__linux__) && !defined(__APPLE__)
+        , buffer_(std::move(other.buffer_))
+#endif
+    {}
+
+    MappedFile& operator=(MappedFile&& other) noexcept {
+        if (this != &other) {
+            close();
+            data_ = std::exchange(other.data_, nullptr);
+            size_ = std::exchange(other.size_, 0);
+#if !defined(__linux__) && !defined(__APPLE__)
+            buffer_ = std::move(other.buffer_);
+#endif
+        }
+        return *this;
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile() { close(); }
+
+    const uint8_t* data() const noexcept { return data_; }
+    size_t size() const noexcept { return size_; }
+
+    void close() noexcept {
+#if defined(__linux__) || defined(__APPLE__)
+        if (data_) {
+            ::munmap(const_cast<uint8_t*>(data_), size_);
+        }
+#else
+        buffer_ = PageBuffer();
+#endif
+        data_ = nullptr;
+        size_ = 0;
+    }
+
+private:
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+#if !defined(__linux__) && !defined(__APPLE__)
+    PageBuffer buffer_;
+#endif
+};
+
+#if defined(HOLOHASH_HAVE_IO_URING)
+// Minimal io_uring submission/completion queue pair over the raw system
+// calls, for fixed-buffer reads only. init() fails where the kernel lacks
+// io_uring or it is disabled, e.g. by a container seccomp policy; callers
+// are expected to fall back to blocking reads.
+class IoUring {
+public:
+    IoUring() noexcept = default;
+    IoUring(const IoUring&) = delete;
+    IoUring& operator=(const IoUring&) = delete;
+
+    ~IoUring() {
+        if (sq_ring_) {
+            ::munmap(sq_ring_, sq_ring_size_);
+        }
+        if (cq_ring_ && cq_ring_ != sq_ring_) {
+            ::munmap(cq_ring_, cq_ring_size_);
+        }
+        if (sqes_) {
+            ::munmap(sqes_, sqes_size_);
+        }
+        if (fd_ >= 0) {
+            ::close(fd_);
+        }
+    }
+
+    bool init(unsigned entries) noexcept {
+        io_uring_params params{};
+        fd_ = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+        if (fd_ < 0) {
+            return false;
+        }
+
+        sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        const bool single = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (single) {
+            sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+        }
+
+        sq_ring_ = map(sq_ring_size_, IORING_OFF_SQ_RING);
+        cq_ring_ = single ? sq_ring_ : map(cq_ring_size_, IORING_OFF_CQ_RING);
+        sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+        sqes_ = static_cast<io_uring_sqe*>(map(sqes_size_, IORING_OFF_SQES));
+        if (!sq_ring_ || !cq_ring_ || !sqes_) {
+            return false;
+        }
+
+        auto* sq = static_cast<uint8_t*>(sq_ring_);
+        sq_head_ = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+        sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sq_mask_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sq_array_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        sq_entries_ = params.sq_entries;
+
+        auto* cq = static_cast<uint8_t*>(cq_ring_);
+        cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cq_mask_ = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+        return true;
+    }
+
+    // Pins buffers for read_fixed(); they must outlive the ring
+    bool register_buffers(const iovec* buffers, unsigned count) noexcept {
+        return ::syscall(__NR_io_uring_register, fd_, IORING_REGISTER_BUFFERS, buffers, count) == 0;
+    }
+
+    // Queues a read into registered buffer buffer_index; false if the
+    // submission queue is full
+    bool read_fixed(int fd, void* buffer, unsigned length, uint64_t offset,
+                    uint16_t buffer_index, uint64_t user_data) noexcept {
+        const unsigned tail = *sq_tail_;
+        if (tail - std::atomic_ref<unsigned>(*sq_head_).load(std::memory_order_acquire) >= sq_entries_) {
+            return false;
+        }
+        const unsigned index = tail & sq_mask_;
+        io_uring_sqe& sqe = sqes_[index];
+        std::memset(&sqe, 0, sizeof(sqe));
+        sqe.opcode = IORING_OP_READ_FIXED;
+        sqe.fd = fd;
+        sqe.addr = reinterpret_cast<uint64_t>(buffer);
+        sqe.len = length;
+        sqe.off = offset;
+        sqe.buf_index = buffer_index;
+        sqe.user_data = user_data;
+        sq_array_[index] = index;
+        std::atomic_ref<unsigned>(*sq_tail_).store(tail + 1, std::memory_order_release);
+        ++pending_;
+        return true;
+    }
+
+    // Submits queued reads and blocks until at least wait completions are
+    // available
+    bool submit_and_wait(unsigned wait) noexcept {
+        for (;;) {
+            long submitted = ::syscall(__NR_io_uring_enter, fd_, pending_, wait,
+                                       wait ? IORING_ENTER_GETEVENTS : 0u, nullptr, 0);
+            if (submitted >= 0) {
+                pending_ -= static_cast<unsigned>(submitted);
+                return true;
+            }
+            if (errno != EINTR) {
+                return false;
+            }
+        }
+    }
+
+    // Takes one completion if any is available
+    bool pop(uint64_t& user_data, int32_t& result) noexcept {
+        const unsigned head = *cq_head_;
+        if (head == std::atomic_ref<unsigned>(*cq_tail_).load(std::memory_order_acquire)) {
+            return false;
+        }
+        const io_uring_cqe& cqe = cqes_[head & cq_mask_];
+        user_data = cqe.user_data;
+        result = cqe.res;
+        std::atomic_ref<unsigned>(*cq_head_).store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    int fd_ = -1;
+    void* sq_ring_ = nullptr;
+    void* cq_ring_ = nullptr;
+    io_uring_sqe* sqes_ = nullptr;
+    size_t sq_ring_size_ = 0;
+    size_t cq_ring_size_ = 0;
+    size_t sqes_size_ = 0;
+
+    unsigned* sq_head_ = nullptr;
+    unsigned* sq_tail_ = nullptr;
+    unsigned* sq_array_ = nullptr;
+    unsigned sq_mask_ = 0;
+    unsigned sq_entries_ = 0;
+    unsigned pending_ = 0;
+
+    unsigned* cq_head_ = nullptr;
+    unsigned* cq_tail_ = nullptr;
+    io_uring_cqe* cqes_ = nullptr;
+    unsigned cq_mask_ = 0;
+
+    void* map(size_t size, off_t offset) noexcept {
+        void* p = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, offset);
+        return p == MAP_FAILED ? nullptr : p;
+    }
+};
+#endif
+
+// Hot kernels of the hash transform, one implementation per SimdLevel.
+// rotate_add, mix_round and transform operate on the 32-byte hash state;
+// the IV is 16 bytes and is added to both halves. All levels are
+// bit-identical to the scalar reference.
+namespace kernels {
+
+namespace scalar {
+
+// Constant evaluation takes the byte loops, so HolographicHash can run at
+// compile time
+constexpr void xor_block(uint8_t* dst, const uint8_t* src, size_t len) noexcept {
+    size_t i = 0;
+    for (; !std::is_constant_evaluated() && i + 8 <= len; i += 8) {
+        uint64_t a, b;
+        std::memcpy(&a, dst + i, sizeof(a));
+        std::memcpy(&b, src + i, sizeof(b));
+        a ^= b;
+        std::memcpy(dst + i, &a, sizeof(a));
+    }
+    for (; i < len; ++i) {
+        dst[i] ^= src[i];
+    }
+}
+
+constexpr void rotate_add(uint8_t* state, const uint8_t* iv) noexcept {
+    for (size_t j = 0; j < 32; ++j) {
+        state[j] = static_cast<uint8_t>(rotate_left(state[j], 3) + iv[j % 16]);
+    }
+}
+
+// Each byte is mixed with its already updated predecessor and its not yet
+// updated successor, wrapping around the state
+constexpr void mix_round(uint8_t* data) noexcept {
+    constexpr size_t size = 32;
+    for (size_t idx = 0; idx < size; ++idx) {
+        uint8_t prev = data[(idx + size - 1) % size];
+        uint8_t next = data[(idx + 1) % size];
+
+        data[idx] = rotate_left(data[idx], 3) ^ prev;
+        data[idx] = rotate_left(data[idx], 2) ^ next;
+        data[idx] = rotate_left(data[idx], 1);
+    }
+}
+
+// Whole transform: for each round, XOR in the round's 32 gathered input
+// bytes, rotate and add the IV, then mix; followed by mix_rounds extra
+// mixing rounds
+constexpr void transform(uint8_t* state, const uint8_t* iv, const uint8_t* gathered,
+                         size_t rounds, size_t mix_rounds) noexcept {
+    for (size_t round = 0; round < rounds; ++round) {
+        xor_block(state, gathered + round * 32, 32);
+        rotate_add(state, iv);
+        mix_round(state);
+    }
+    for (size_t round = 0; round < mix_rounds; ++round) {
+        mix_round(state);
+    }
+}
+
+} // namespace scalar
+
+// The transform for a state of Width bytes with the round counts fixed at
+// compile time, used by the BasicHolographicHash profiles. Every byte loop
+// is expanded in full, so the compiler schedules across bytes with all
+// indices and wrap-arounds resolved; the round loops stay rolled, which
+// keeps 512-bit profiles within the instruction cache. For Width 32 it
+// computes exactly what scalar::transform does.
+namespace fixed {
+
+template<size_t Count, typename Fn>
+constexpr void unroll(Fn&& fn) noexcept {
+    [&]<size_t... I>(std::index_sequence<I...>) {
+        (fn(std::integral_constant<size_t, I>{}), ...);
+    }(std::make_index_sequence<Count>{});
+}
+
+template<size_t Width>
+constexpr void mix_round(std::array<uint8_t, Width>& data) noexcept {
+    unroll<Width>([&](auto i) {
+        constexpr size_t idx = i;
+        const uint8_t prev = data[(idx + Width - 1) % Width];
+        const uint8_t next = data[(idx + 1) % Width];
+        uint8_t x = rotate_left(data[idx], 3) ^ prev;
+        x = rotate_left(x, 2) ^ next;
+        data[idx] = rotate_left(x, 1);
+    });
+}
+
+template<size_t Width, size_t Rounds, size_t MixRounds>
+constexpr void transform(std::array<uint8_t, Width>& state, const std::array<uint8_t, 16>& iv,
+                         const std::array<uint8_t, Rounds * Width>& gathered) noexcept {
+    for (size_t round = 0; round < Rounds; ++round) {
+        unroll<Width>([&](auto j) {
+            const uint8_t x = state[j] ^ gathered[round * Width + j];
+            state[j] = static_cast<uint8_t>(rotate_left(x, 3) + iv[j % 16]);
+        });
+        mix_round(state);
+    }
+    for (size_t round = 0; round < MixRounds; ++round) {
+        mix_round(state);
+    }
+}
+
+} // namespace fixed
+
+// The vector mix_round unrolls the scalar recurrence. Since rotations
+// distribute over XOR, byte i of a round is
+//     n[i] = rotl6(o[i]) ^ rotl1(o[i+1]) ^ rotl3(n[i-1])
+// which is a prefix scan over a[i] = rotl6(o[i]) ^ rotl1(o[i+1]) with
+// rotl3 as the carry. The scan takes five shift/rotate/XOR steps; the two
+// wrap-around terms (o[31] into byte 0, n[0] into byte 31) are patched in
+// with whole-state byte shifts.
+
+#if defined(HOLOHASH_ARCH_X64)
+namespace sse2 {
+
+template<unsigned Count>
+inline __m128i rotl_epi8(__m128i v) noexcept {
+    if constexpr (Count % 8 == 0) {
+        return v;
+    } else {
+        constexpr unsigned c = Count % 8;
+        const __m128i hi_mask = _mm_set1_epi8(static_cast<char>(0xFFu << c));
+        const __m128i lo_mask = _mm_set1_epi8(static_cast<char>(0xFFu >> (8 - c)));
+        return _mm_or_si128(_mm_and_si128(_mm_slli_epi16(v, c), hi_mask),
+                            _mm_and_si128(_mm_srli_epi16(v, 8 - c), lo_mask));
+    }
+}
+
+// The 32-byte state as two halves; shl moves byte i to i + N, shr to i - N
+struct State {
+    __m128i lo, hi;
+
+    static State load(const uint8_t* src) noexcept {
+        return {_mm_loadu_si128(reinterpret_cast<const __m128i*>(src)),
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 16))};
+    }
+
+    void store(uint8_t* dst) const noexcept {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), lo);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 16), hi);
+    }
+
+    friend State operator^(State a, State b) noexcept {
+        return {_mm_xor_si128(a.lo, b.lo), _mm_xor_si128(a.hi, b.hi)};
+    }
+
+    template<unsigned Count>
+    State rotl() const noexcept {
+        return {rotl_epi8<Count>(lo), rotl_epi8<Count>(hi)};
+    }
+
+    template<int N>
+    State shl() const noexcept {
+        if constexpr (N < 16) {
+            return {_mm_slli_si128(lo, N),
+                    _mm_or_si128(_mm_slli_si128(hi, N), _mm_srli_si128(lo, 16 - N))};
+        } else {
+            return {_mm_setzero_si128(), _mm_slli_si128(lo, N - 16)};
+        }
+    }
+
+    template<int N>
+    State shr() const noexcept {
+        if constexpr (N < 16) {
+            return {_mm_or_si128(_mm_srli_si128(lo, N), _mm_slli_si128(hi, 16 - N)),
+                    _mm_srli_si128(hi, N)};
+        } else {
+            return {_mm_srli_si128(hi, N - 16), _mm_setzero_si128()};
+        }
+    }
+};
+
+template<typename S>
+inline S mix_state(S o) noexcept {
+    S next = o.template shr<1>() ^ o.template shl<31>();
+    S a = o.template rotl<6>() ^ next.template rotl<1>() ^ o.template rotl<3>().template shr<31>();
+
+    S n = a;
+    n = n ^ n.template shl<1>().template rotl<3>();
+    n = n ^ n.template shl<2>().template rotl<6>();
+    n = n ^ n.template shl<4>().template rotl<4>();
+    n = n ^ n.template shl<8>();
+    n = n ^ n.template shl<16>();
+
+    return n ^ (o ^ a).template shl<31>().template rotl<1>();
+}
+
+inline void xor_block(uint8_t* dst, const uint8_t* src, size_t len) noexcept {
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16) {
+        __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+        __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_xor_si128(d, s));
+    }
+    scalar::xor_block(dst + i, src + i, len - i);
+}
+
+inline void rotate_add(uint8_t* state, const uint8_t* iv) noexcept {
+    State s = State::load(state).rotl<3>();
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(iv));
+    State{_mm_add_epi8(s.lo, v), _mm_add_epi8(s.hi, v)}.store(state);
+}
+
+inline void mix_round(uint8_t* data) noexcept {
+    mix_state(State::load(data)).store(data);
+}
+
+// The state stays in two registers from the first round to the last
+inline void transform(uint8_t* state, const uint8_t* iv, const uint8_t* gathered,
+                      size_t rounds, size_t mix_rounds) noexcept {
+    State s = State::load(state);
+    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(iv));
+
+    for (size_t round = 0; round < rounds; ++round) {
+        s = (s ^ State::load(gathered + round * 32)).rotl<3>();
+        s = mix_state(State{_mm_add_epi8(s.lo, v), _mm_add_epi8(s.hi, v)});
+    }
+    for (size_t round = 0; round < mix_rounds; ++round) {
+        s = mix_state(s);
+    }
+
+    s.store(state);
+}
+
+} // namespace sse2
+
+namespace avx2 {
+
+template<unsigned Count>
+HOLOHASH_TARGET_AVX2 inline __m256i rotl_epi8(__m256i v) noexcept {
+    if constexpr (Count % 8 == 0) {
+        return v;
+    } else {
+        constexpr unsigned c = Count % 8;
+        const __m256i hi_mask = _mm256_set1_epi8(static_cast<char>(0xFFu << c));
+        const __m256i lo_mask = _mm256_set1_epi8(static_cast<char>(0xFFu >> (8 - c)));
+        return _mm256_or_si256(_mm256_and_si256(_mm256_slli_epi16(v, c), hi_mask),
+                               _mm256_and_si256(_mm256_srli_epi16(v, 8 - c), lo_mask));
+    }
+}
+
+// Whole-register byte shifts; AVX2 byte shifts only work within 128-bit
+// halves, so the half that crosses over is brought in with a permute
+template<int N>
+HOLOHASH_TARGET_AVX2 inline __m256i shl_bytes(__m256i v) noexcept {
+    __m256i carry = _mm256_permute2x128_si256(v, v, 0x08);
+    if constexpr (N < 16) {
+        return _mm256_alignr_epi8(v, carry, 16 - N);
+    } else {
+        return _mm256_slli_si256(carry, N - 16);
+    }
+}
+
+template<int N>
+HOLOHASH_TARGET_AVX2 inline __m256i shr_bytes(__m256i v) noexcept {
+    __m256i carry = _mm256_permute2x128_si256(v, v, 0x81);
+    if constexpr (N < 16) {
+        return _mm256_alignr_epi8(carry, v, N);
+    } else {
+        return _mm256_srli_si256(carry, N - 16);
+    }
+}
+
+HOLOHASH_TARGET_AVX2 inline __m256i mix_state(__m256i o) noexcept {
+    __m256i next = _mm256_xor_si256(shr_bytes<1>(o), shl_bytes<31>(o));
+    __m256i a = _mm256_xor_si256(
+        _mm256_xor_si256(rotl_epi8<6>(o), rotl_epi8<1>(next)),
+        shr_bytes<31>(rotl_epi8<3>(o)));
+
+    __m256i n = a;
+    n = _mm256_xor_si256(n, rotl_epi8<3>(shl_bytes<1>(n)));
+    n = _mm256_xor_si256(n, rotl_epi8<6>(shl_bytes<2>(n)));
+    n = _mm256_xor_si256(n, rotl_epi8<4>(shl_bytes<4>(n)));
+    n = _mm256_xor_si256(n, shl_bytes<8>(n));
+    n = _mm256_xor_si256(n, shl_bytes<16>(n));
+
+    return _mm256_xor_si256(n, rotl_epi8<1>(shl_bytes<31>(_mm256_xor_si256(o, a))));
+}
+
+HOLOHASH_TARGET_AVX2 inline void xor_block(uint8_t* dst, const uint8_t* src, size_t len) noexcept {
+    size_t i = 0;
+    for (; i + 32 <= len; i += 32) {
+        __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst + i));
+        __m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_xor_si256(d, s));
+    }
+    sse2::xor_block(dst + i, src + i, len - i);
+}
+
+HOLOHASH_TARGET_AVX2 inline void rotate_add(uint8_t* state, const uint8_t* iv) noexcept {
+    __m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(state));
+    __m256i v = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(iv)));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(state), _mm256_add_epi8(rotl_epi8<3>(s), v));
+}
+
+HOLOHASH_TARGET_AVX2 inline void mix_round(uint8_t* data) noexcept {
+    __m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(data), mix_state(s));
+}
+
+// The whole state lives in one register from the first round to the last
+HOLOHASH_TARGET_AVX2 inline void transform(uint8_t* state, const uint8_t* iv, const uint8_t* gathered,
+                                           size_t rounds, size_t mix_rounds) noexcept {
+    __m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(state));
+    const __m256i v = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(iv)));
+
+    for (size_t round = 0; round < rounds; ++round) {
+        __m256i g = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(gathered + round * 32));
+        s = _mm256_add_epi8(rotl_epi8<3>(_mm256_xor_si256(s, g)), v);
+        s = mix_state(s);
+    }
+    for (size_t round = 0; round < mix_rounds; ++round) {
+        s = mix_state(s);
+    }
+
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(state), s);
+}
+
+} // namespace avx2
+
+// The 32-byte state kernels gain nothing from 512-bit registers, so this
+// level only widens the block XOR
+namespace avx512 {
+
+HOLOHASH_TARGET_AVX512 inline void xor_block(uint8_t* dst, const uint8_t* src, size_t len) noexcept {
+    size_t i = 0;
+    for (; i + 64 <= len; i += 64) {
+        __m512i d = _mm512_loadu_si512(dst + i);
+        __m512i s = _mm512_loadu_si512(src + i);
+        _mm512_storeu_si512(dst + i, _mm512_xor_si512(d, s));
+    }
+    avx2::xor_block(dst + i, src + i, len - i);
+}
+
+} // namespace avx512
+#endif
+
+} // namespace kernels
+
+// Function table for one SimdLevel
+struct KernelTable {
+    SimdLevel level;
+    void (*xor_block)(uint8_t* dst, const uint8_t* src, size_t len) noexcept;
+    void (*rotate_add)(uint8_t* state, const uint8_t* iv) noexcept;
+    void (*mix_round)(uint8_t* state) noexcept;
+    void (*transform)(uint8_t* state, const uint8_t* iv, const uint8_t* gathered,
+                      size_t rounds, size_t mix_rounds) noexcept;
+};
+
+// Table for the given level, or for the closest lower level built for
+// this architecture
+inline const KernelTable& kernel_table(SimdLevel level) noexcept {
+    static constexpr KernelTable scalar_table{
+        SimdLevel::scalar, kernels::scalar::xor_block, kernels::scalar::rotate_add, kernels::scalar::mix_round,
+        kernels::scalar::transform
+    };
+#if defined(HOLOHASH_ARCH_X64)
+    static constexpr KernelTable sse2_table{
+        SimdLevel::sse2, kernels::sse2::xor_block, kernels::sse2::rotate_add, kernels::sse2::mix_round,
+        kernels::sse2::transform
+    };
+    static constexpr KernelTable avx2_table{
+        SimdLevel::avx2, kernels::avx2::xor_block, kernels::avx2::rotate_add, kernels::avx2::mix_round,
+        kernels::avx2::transform
+    };
+    static constexpr KernelTable avx512_table{
+        SimdLevel::avx512, kernels::avx512::xor_block, kernels::avx2::rotate_add, kernels::avx2::mix_round,
+        kernels::avx2::transform
+    };
+
+    switch (level) {
+        case SimdLevel::avx512: return avx512_table;
+        case SimdLevel::avx2: return avx2_table;
+        case SimdLevel::sse2: return sse2_table;
+        default: return scalar_table;
+    }
+#else
+    (void)level;
+    return scalar_table;
+#endif
+}
+
+namespace detail {
+    // Resolved on first use: the detected level, lowered to HOLOHASH_SIMD
+    // when that variable names a supported level
+    inline std::atomic<const KernelTable*>& active_kernel_slot() noexcept {
+        static std::atomic<const KernelTable*> slot{[] {
+            SimdLevel level = detect_simd_level();
+            SimdLevel requested;
+            if (requested_simd_level(requested) && requested < level) {
+                level = requested;
+            }
+            return &kernel_table(level);
+        }()};
+        return slot;
+    }
+}
+
+inline const KernelTable& active_kernels() noexcept {
+    return *detail::active_kernel_slot().load(std::memory_order_relaxed);
+}
+
+inline SimdLevel active_simd_level() noexcept {
+    return active_kernels().level;
+}
+
+// Forces a kernel level, e.g. from configuration. Requests above what the
+// CPU supports are lowered; the level actually selected is returned.
+inline SimdLevel set_simd_level(SimdLevel level) noexcept {
+    if (level > detect_simd_level()) {
+        level = detect_simd_level();
+    }
+    const KernelTable& table = kernel_table(level);
+    detail::active_kernel_slot().store(&table, std::memory_order_relaxed);
+    return table.level;
+}
+
+// Block XOR through the active kernel level
+inline void simd_xor_block(uint8_t* dst, const uint8_t* src, size_t len) noexcept {
+    active_kernels().xor_block(dst, src, len);
+}
+
 } // namespace platform
 } // namespace holohash
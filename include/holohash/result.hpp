@@ -0,0 +1,54 @@
+#pragma once
+#include <cstdint>
+#include <type_traits>
+
+namespace holohash {
+
+// Failure reasons reported by the try_ functions, which never throw
+enum class ErrorCode : uint8_t {
+    empty_input,    // the input span was empty
+    out_of_memory,  // storing a key needed memory that was not available
+    key_store       // the keychain rejected the key, e.g. its log failed
+};
+
+inline const char* error_message(ErrorCode error) noexcept {
+    switch (error) {
+        case ErrorCode::empty_input: return "Input data cannot be empty";
+        case ErrorCode::out_of_memory: return "Out of memory";
+        case ErrorCode::key_store: return "Key could not be stored";
+    }
+    return "Unknown error";
+}
+
+// A value or the ErrorCode that prevented it, after std::expected. Only for
+// the trivially copyable digests, nonces and keys, so it never allocates.
+template<typename T>
+class HashResult {
+    static_assert(std::is_trivially_copyable_v<T>);
+
+public:
+    HashResult(const T& value) noexcept : value_(value), ok_(true) {}
+    HashResult(ErrorCode error) noexcept : error_(error), ok_(false) {}
+
+    bool has_value() const noexcept { return ok_; }
+    explicit operator bool() const noexcept { return ok_; }
+
+    // Only valid when has_value()
+    const T& value() const noexcept { return value_; }
+    const T& operator*() const noexcept { return value_; }
+    const T* operator->() const noexcept { return &value_; }
+
+    // Only valid when !has_value()
+    ErrorCode error() const noexcept { return error_; }
+
+    T value_or(const T& fallback) const noexcept { return ok_ ? value_ : fallback; }
+
+private:
+    union {
+        T value_;
+        ErrorCode error_;
+    };
+    bool ok_;
+};
+
+} // namespace holohash
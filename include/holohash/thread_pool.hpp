@@ -0,0 +1,226 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace holohash {
+
+// Fixed set of worker threads for data-parallel loops. parallel_for() runs
+// on the calling thread as well as on any idle workers, so it completes
+// even when every worker is busy, and may be nested or called from several
+// threads at once.
+//
+// Each loop is split into one contiguous index range per participant.
+// Participants take indices from the front of their own range; once it is
+// empty they steal the back half of another participant's range. Uneven
+// work thus balances itself, while each participant mostly walks adjacent
+// indices and touches only its own range.
+class ThreadPool {
+public:
+    static constexpr size_t automatic = static_cast<size_t>(-1);
+
+    // threads is the number of workers besides the calling thread, so 0
+    // runs every loop on the caller; automatic picks one less than the
+    // hardware concurrency
+    explicit ThreadPool(size_t threads = automatic) {
+        if (threads == automatic) {
+            threads = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+        }
+        workers_.reserve(threads);
+        for (size_t i = 0; i < threads; ++i) {
+            workers_.emplace_back([this] { run(); });
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    ~ThreadPool() {
+        {
+            std::lock_guard lock(mutex_);
+            stop_ = true;
+        }
+        wake_.notify_all();
+        for (auto& worker : workers_) {
+            worker.join();
+        }
+    }
+
+    // Threads taking part in a parallel_for(), the caller included
+    size_t concurrency() const noexcept { return workers_.size() + 1; }
+
+    // Calls fn(i) for every i in [0, count) and returns when all calls have
+    // finished. The first exception thrown by fn is rethrown here; indices
+    // not yet started are then skipped.
+    template<typename Fn>
+    void parallel_for(size_t count, Fn&& fn) {
+        if (count == 0) {
+            return;
+        }
+
+        const size_t helpers = std::min(workers_.size(), count - 1);
+        auto job = std::make_shared<Job>(count, helpers + 1);
+        job->body = [&fn](size_t i) { fn(i); };
+
+        if (helpers > 0) {
+            {
+                std::lock_guard lock(mutex_);
+                for (size_t i = 0; i < helpers; ++i) {
+                    tasks_.push_back(job);
+                }
+            }
+            if (helpers == workers_.size()) {
+                wake_.notify_all();
+            } else {
+                for (size_t i = 0; i < helpers; ++i) {
+                    wake_.notify_one();
+                }
+            }
+        }
+
+        job->work(job->join());
+
+        std::unique_lock lock(job->mutex);
+        job->finished.wait(lock, [&] { return job->done == job->count; });
+        if (job->error) {
+            std::rethrow_exception(job->error);
+        }
+    }
+
+    // Process-wide pool, started on first use
+    static ThreadPool& shared() {
+        static ThreadPool pool;
+        return pool;
+    }
+
+private:
+    // Indices [begin, end) still owned by one participant
+    struct alignas(64) Range {
+        std::mutex mutex;
+        size_t begin = 0;
+        size_t end = 0;
+    };
+
+    struct Job {
+        size_t count;
+        std::function<void(size_t)> body;
+        std::unique_ptr<Range[]> ranges;
+        size_t participants;
+        std::atomic<size_t> joined{0};
+        std::atomic<bool> failed{false};
+
+        std::mutex mutex;
+        std::condition_variable finished;
+        size_t done = 0;
+        std::exception_ptr error;
+
+        Job(size_t n, size_t p) : count(n), ranges(std::make_unique<Range[]>(p)), participants(p) {
+            for (size_t i = 0; i < p; ++i) {
+                ranges[i].begin = n * i / p;
+                ranges[i].end = n * (i + 1) / p;
+            }
+        }
+
+        // Range index of the next participant to arrive
+        size_t join() noexcept { return joined.fetch_add(1, std::memory_order_relaxed); }
+
+        void work(size_t self) {
+            size_t completed = 0;
+            for (size_t i;;) {
+                if (!take(self, i)) {
+                    if (steal(self)) {
+                        continue;
+                    }
+                    break;
+                }
+                ++completed;
+                if (failed.load(std::memory_order_relaxed)) {
+                    continue;
+                }
+                try {
+                    body(i);
+                } catch (...) {
+                    std::lock_guard lock(mutex);
+                    if (!error) {
+                        error = std::current_exception();
+                    }
+                    failed.store(true, std::memory_order_relaxed);
+                }
+            }
+            if (completed > 0) {
+                std::lock_guard lock(mutex);
+                done += completed;
+                if (done == count) {
+                    finished.notify_all();
+                }
+            }
+        }
+
+        bool take(size_t self, size_t& index) {
+            Range& own = ranges[self];
+            std::lock_guard lock(own.mutex);
+            if (own.begin == own.end) {
+                return false;
+            }
+            index = own.begin++;
+            return true;
+        }
+
+        // Moves the back half of the first non-empty range after self into
+        // self's range; false once every range is empty
+        bool steal(size_t self) {
+            for (size_t k = 1; k < participants; ++k) {
+                Range& victim = ranges[(self + k) % participants];
+                size_t begin;
+                size_t end;
+                {
+                    std::lock_guard lock(victim.mutex);
+                    if (victim.begin == victim.end) {
+                        continue;
+                    }
+                    end = victim.end;
+                    begin = victim.begin + (victim.end - victim.begin) / 2;
+                    victim.end = begin;
+                }
+                Range& own = ranges[self];
+                std::lock_guard lock(own.mutex);
+                own.begin = begin;
+                own.end = end;
+                return true;
+            }
+            return false;
+        }
+    };
+
+    std::vector<std::thread> workers_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::deque<std::shared_ptr<Job>> tasks_;
+    bool stop_ = false;
+
+    void run() {
+        for (;;) {
+            std::shared_ptr<Job> job;
+            {
+                std::unique_lock lock(mutex_);
+                wake_.wait(lock, [this] { return stop_ || !tasks_.empty(); });
+                if (tasks_.empty()) {
+                    return;
+                }
+                job = std::move(tasks_.front());
+                tasks_.pop_front();
+            }
+            job->work(job->join());
+        }
+    }
+};
+
+} // namespace holohash
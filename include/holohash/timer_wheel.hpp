@@ -0,0 +1,187 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <array>
+#include <bit>
+#include <algorithm>
+
+namespace holohash {
+
+// Intrusive links an element carries to sit in a TimerWheel
+template<typename T>
+struct TimerHook {
+    T* prev = nullptr;
+    T* next = nullptr;
+    uint64_t deadline = 0;   // absolute tick
+    uint8_t level = 0;
+    uint8_t slot = 0;
+    bool linked = false;
+};
+
+// Hierarchical timer wheel over intrusive elements. Four levels of 64
+// slots cover 64^4 ticks ahead; later deadlines park in the top level and
+// are re-filed as time approaches them. schedule() and cancel() are O(1),
+// and advance() costs O(expired + cascaded) plus one step per 64-tick
+// window of the lowest non-empty level, so idle periods are skipped in
+// large strides instead of tick by tick. GetHook maps an element pointer
+// to its TimerHook.
+template<typename T, typename GetHook>
+class TimerWheel {
+public:
+    static constexpr unsigned slot_bits = 6;
+    static constexpr size_t slots = size_t{1} << slot_bits;
+    static constexpr size_t levels = 4;
+    static constexpr uint64_t horizon = uint64_t{1} << (slot_bits * levels);
+
+    explicit TimerWheel(uint64_t now = 0) noexcept : now_(now) {}
+
+    uint64_t now() const noexcept { return now_; }
+    size_t size() const noexcept { return size_; }
+
+    // Elements due at or before now() are reported by the next advance()
+    void schedule(T* item, uint64_t deadline) noexcept {
+        auto& hook = GetHook{}(item);
+        hook.deadline = deadline;
+        file(item, hook);
+        ++size_;
+    }
+
+    void cancel(T* item) noexcept {
+        auto& hook = GetHook{}(item);
+        if (hook.linked) {
+            unlink(hook);
+            --size_;
+        }
+    }
+
+    // Moves time forward to tick, calling on_expire(item) for every element
+    // whose deadline has been reached. Expired elements are unlinked before
+    // the callback runs, so the callback may destroy them.
+    template<typename OnExpire>
+    void advance(uint64_t tick, OnExpire&& on_expire) {
+        while (now_ < tick) {
+            if (size_ == 0) {
+                now_ = tick;
+                break;
+            }
+
+            // Skip whole windows of empty lower levels
+            size_t empty = 0;
+            while (empty < levels && occupied_[empty] == 0) {
+                ++empty;
+            }
+            uint64_t next = now_ + 1;
+            if (empty > 0) {
+                const uint64_t stride = uint64_t{1} << (slot_bits * std::min(empty, levels - 1));
+                next = std::min(tick, (now_ | (stride - 1)) + 1);
+            }
+            now_ = next;
+
+            // Re-file higher levels whose slot boundary was reached, top down
+            for (size_t level = levels - 1; level > 0; --level) {
+                const uint64_t mask = (uint64_t{1} << (slot_bits * level)) - 1;
+                if ((now_ & mask) == 0) {
+                    cascade(level, (now_ >> (slot_bits * level)) & (slots - 1), on_expire);
+                }
+            }
+
+            expire_slot(now_ & (slots - 1), on_expire);
+        }
+    }
+
+private:
+    std::array<std::array<T*, slots>, levels> heads_{};
+    std::array<uint64_t, levels> occupied_{};
+    uint64_t now_;
+    size_t size_ = 0;
+
+    void file(T* item, TimerHook<T>& hook) noexcept {
+        uint64_t deadline = hook.deadline;
+        if (deadline <= now_) {
+            deadline = now_ + 1;
+        }
+
+        uint64_t delta = deadline - now_;
+        if (delta >= horizon) {
+            deadline = now_ + horizon - 1;
+            delta = horizon - 1;
+        }
+
+        size_t level = 0;
+        while (delta >= (uint64_t{1} << (slot_bits * (level + 1)))) {
+            ++level;
+        }
+
+        const size_t slot = (deadline >> (slot_bits * level)) & (slots - 1);
+        hook.level = static_cast<uint8_t>(level);
+        hook.slot = static_cast<uint8_t>(slot);
+        hook.prev = nullptr;
+        hook.next = heads_[level][slot];
+        if (hook.next) {
+            GetHook{}(hook.next).prev = item;
+        }
+        heads_[level][slot] = item;
+        occupied_[level] |= uint64_t{1} << slot;
+        hook.linked = true;
+    }
+
+    void unlink(TimerHook<T>& hook) noexcept {
+        if (hook.prev) {
+            GetHook{}(hook.prev).next = hook.next;
+        } else {
+            heads_[hook.level][hook.slot] = hook.next;
+            if (!hook.next) {
+                occupied_[hook.level] &= ~(uint64_t{1} << hook.slot);
+            }
+        }
+        if (hook.next) {
+            GetHook{}(hook.next).prev = hook.prev;
+        }
+        hook.prev = hook.next = nullptr;
+        hook.linked = false;
+    }
+
+    T* take_slot(size_t level, size_t slot) noexcept {
+        T* list = heads_[level][slot];
+        heads_[level][slot] = nullptr;
+        occupied_[level] &= ~(uint64_t{1} << slot);
+        return list;
+    }
+
+    template<typename OnExpire>
+    void cascade(size_t level, size_t slot, OnExpire& on_expire) {
+        T* item = take_slot(level, slot);
+        while (item) {
+            auto& hook = GetHook{}(item);
+            T* next = hook.next;
+            hook.linked = false;
+            if (hook.deadline <= now_) {
+                --size_;
+                on_expire(item);
+            } else {
+                file(item, hook);
+            }
+            item = next;
+        }
+    }
+
+    template<typename OnExpire>
+    void expire_slot(size_t slot, OnExpire& on_expire) {
+        T* item = take_slot(0, slot);
+        while (item) {
+            auto& hook = GetHook{}(item);
+            T* next = hook.next;
+            hook.linked = false;
+            if (hook.deadline <= now_) {
+                --size_;
+                on_expire(item);
+            } else {
+                // Parked beyond the horizon; not due yet
+                file(item, hook);
+            }
+            item = next;
+        }
+    }
+};
+
+} // namespace holohash
@@ -5,28 +5,49 @@
 #include <vector>
 #include <cstdint>
 #include <functional>
+#include <cstring>
+#include <span>
+#include <type_traits>
 
 namespace holohash {
 
+// Power-of-two sized values up to a cache line (digests, nonces, keys) are
+// aligned to their size so vector kernels can load and store them directly
+template<typename T>
+constexpr size_t strong_type_alignment =
+    (sizeof(T) & (sizeof(T) - 1)) == 0 && sizeof(T) <= 64 && sizeof(T) > alignof(T)
+        ? sizeof(T) : alignof(T);
+
 // Strong type pattern for type safety
 template<typename T, typename Tag>
-class StrongType {
+class alignas(strong_type_alignment<T>) StrongType {
     T value_;
 public:
-    explicit StrongType(const T& value) : value_(value) {}
-    explicit StrongType(T&& value) : value_(std::move(value)) {}
-    T& get() { return value_; }
-    const T& get() const { return value_; }
+    constexpr explicit StrongType(const T& value) : value_(value) {}
+    constexpr explicit StrongType(T&& value) : value_(std::move(value)) {}
+    constexpr T& get() { return value_; }
+    constexpr const T& get() const { return value_; }
     
-    bool operator==(const StrongType& other) const {
+    constexpr bool operator==(const StrongType& other) const {
         return value_ == other.value_;
     }
     
-    bool operator!=(const StrongType& other) const {
+    constexpr bool operator!=(const StrongType& other) const {
         return !(*this == other);
     }
 };
 
+// Bytes of a string literal without its terminator, for hashing constant
+// identifiers at compile time
+template<size_t N>
+consteval std::array<uint8_t, N - 1> literal_bytes(const char (&text)[N]) {
+    std::array<uint8_t, N - 1> bytes{};
+    for (size_t i = 0; i + 1 < N; ++i) {
+        bytes[i] = static_cast<uint8_t>(text[i]);
+    }
+    return bytes;
+}
+
 // Session parameters struct
 struct SessionParams {
     std::string source_ip;
@@ -48,23 +69,192 @@ struct SystemState {
     bool operator==(const SystemState&) const = default;
 };
 
+// Binary network address; size is 4 for IPv4 and 16 for IPv6
+struct IpAddress {
+    std::array<uint8_t, 16> bytes{};
+    uint8_t size = 0;
+
+    constexpr IpAddress() noexcept = default;
+
+    constexpr IpAddress(const std::array<uint8_t, 4>& v4) noexcept : size(4) {
+        for (size_t i = 0; i < v4.size(); ++i) {
+            bytes[i] = v4[i];
+        }
+    }
+
+    constexpr IpAddress(const std::array<uint8_t, 16>& v6) noexcept : bytes(v6), size(16) {}
+
+    constexpr std::span<const uint8_t> view() const noexcept { return {bytes.data(), size}; }
+
+    bool operator==(const IpAddress&) const = default;
+};
+
+// Fixed-size, allocation-free forms of SessionParams and SystemState for
+// per-packet use. Addresses, content digest and previous nonce are stored
+// inline in binary form; a packed context hashes like a SessionParams /
+// SystemState holding those same bytes, with no session metadata.
+struct PackedSession {
+    IpAddress source_ip;
+    IpAddress dest_ip;
+    std::chrono::system_clock::time_point timestamp{};
+
+    bool operator==(const PackedSession&) const = default;
+};
+
+struct PackedState {
+    std::array<uint8_t, 32> content_hash{};
+    double cpu_load = 0.0;
+    uint64_t memory_usage = 0;
+    std::chrono::system_clock::time_point timestamp{};
+    std::array<uint8_t, 16> previous_nonce{};
+    bool has_previous_nonce = false;
+
+    bool operator==(const PackedState&) const = default;
+};
+
+static_assert(std::is_trivially_copyable_v<PackedSession>);
+static_assert(std::is_trivially_copyable_v<PackedState>);
+
+namespace detail {
+
+inline std::span<const uint8_t> bytes_of(const std::string& text) noexcept {
+    return {reinterpret_cast<const uint8_t*>(text.data()), text.size()};
+}
+
+inline bool same_bytes(std::span<const uint8_t> a, std::span<const uint8_t> b) noexcept {
+    return a.size() == b.size() && (a.empty() || std::memcmp(a.data(), b.data(), a.size()) == 0);
+}
+
+} // namespace detail
+
+// Non-owning view of a session context. Every API that reads a context
+// takes a view, so SessionParams, PackedSession or caller-owned buffers can
+// be passed without copying. The viewed data must outlive the call.
+struct SessionView {
+    std::span<const uint8_t> source_ip;
+    std::span<const uint8_t> dest_ip;
+    std::chrono::system_clock::time_point timestamp{};
+    std::span<const uint8_t> metadata;
+
+    constexpr SessionView(
+        std::span<const uint8_t> source,
+        std::span<const uint8_t> dest,
+        std::chrono::system_clock::time_point ts,
+        std::span<const uint8_t> meta = {}
+    ) noexcept : source_ip(source), dest_ip(dest), timestamp(ts), metadata(meta) {}
+
+    SessionView(const SessionParams& params) noexcept
+        : source_ip(detail::bytes_of(params.source_ip)),
+          dest_ip(detail::bytes_of(params.dest_ip)),
+          timestamp(params.timestamp),
+          metadata(params.metadata) {}
+
+    constexpr SessionView(const PackedSession& session) noexcept
+        : source_ip(session.source_ip.view()),
+          dest_ip(session.dest_ip.view()),
+          timestamp(session.timestamp) {}
+
+    // Owning copy
+    SessionParams to_params() const {
+        return SessionParams{
+            std::string(source_ip.begin(), source_ip.end()),
+            std::string(dest_ip.begin(), dest_ip.end()),
+            timestamp,
+            std::vector<uint8_t>(metadata.begin(), metadata.end())
+        };
+    }
+
+    bool operator==(const SessionView& other) const noexcept {
+        return detail::same_bytes(source_ip, other.source_ip) &&
+               detail::same_bytes(dest_ip, other.dest_ip) &&
+               timestamp == other.timestamp &&
+               detail::same_bytes(metadata, other.metadata);
+    }
+};
+
+// Non-owning view of a system state; see SessionView
+struct StateView {
+    std::span<const uint8_t> content_hash;
+    double cpu_load = 0.0;
+    uint64_t memory_usage = 0;
+    std::chrono::system_clock::time_point timestamp{};
+    std::span<const uint8_t> previous_nonce;
+
+    constexpr StateView(
+        std::span<const uint8_t> content,
+        double cpu,
+        uint64_t memory,
+        std::chrono::system_clock::time_point ts,
+        std::span<const uint8_t> previous = {}
+    ) noexcept : content_hash(content), cpu_load(cpu), memory_usage(memory), timestamp(ts), previous_nonce(previous) {}
+
+    StateView(const SystemState& state) noexcept
+        : content_hash(detail::bytes_of(state.content_hash)),
+          cpu_load(state.cpu_load),
+          memory_usage(state.memory_usage),
+          timestamp(state.timestamp),
+          previous_nonce(state.previous_nonce) {}
+
+    StateView(const PackedState& state) noexcept
+        : content_hash(state.content_hash),
+          cpu_load(state.cpu_load),
+          memory_usage(state.memory_usage),
+          timestamp(state.timestamp),
+          previous_nonce(state.previous_nonce.data(), state.has_previous_nonce ? state.previous_nonce.size() : 0) {}
+
+    // Owning copy
+    SystemState to_state() const {
+        return SystemState{
+            std::string(content_hash.begin(), content_hash.end()),
+            cpu_load,
+            memory_usage,
+            timestamp,
+            std::vector<uint8_t>(previous_nonce.begin(), previous_nonce.end())
+        };
+    }
+
+    bool operator==(const StateView& other) const noexcept {
+        return detail::same_bytes(content_hash, other.content_hash) &&
+               cpu_load == other.cpu_load &&
+               memory_usage == other.memory_usage &&
+               timestamp == other.timestamp &&
+               detail::same_bytes(previous_nonce, other.previous_nonce);
+    }
+};
+
 // Type-safe wrappers
 using Hash = StrongType<std::array<uint8_t, 32>, struct HashTag>;
 using Nonce = StrongType<std::array<uint8_t, 16>, struct NonceTag>;
 using Key = StrongType<std::array<uint8_t, 32>, struct KeyTag>;
 
+// Digest of a BasicHolographicHash profile. The 256-bit digest is Hash, so
+// the standard profile is interchangeable with HolographicHash.
+template<size_t Bits>
+struct DigestTag {};
+
+template<size_t Bits>
+using Digest = std::conditional_t<Bits == 256, Hash, StrongType<std::array<uint8_t, Bits / 8>, DigestTag<Bits>>>;
+
 } // namespace holohash
 
-// Custom hash implementation for Key type
+// Keys are uniformly distributed, so a word of their bits is already a good
+// hash. The leading word is left to shard selection.
 namespace std {
     template<>
     struct hash<holohash::Key> {
-        size_t operator()(const holohash::Key& k) const {
-            const auto& arr = k.get();
-            size_t hash = 0;
-            for (const auto& byte : arr) {
-                hash = (hash * 31) + byte;
-            }
+        size_t operator()(const holohash::Key& k) const noexcept {
+            size_t hash;
+            std::memcpy(&hash, k.get().data() + 8, sizeof(hash));
+            return hash;
+        }
+    };
+
+    // For sharding and dedupe tables keyed by profile digests
+    template<size_t N, size_t Bits>
+    struct hash<holohash::StrongType<std::array<uint8_t, N>, holohash::DigestTag<Bits>>> {
+        size_t operator()(const holohash::StrongType<std::array<uint8_t, N>, holohash::DigestTag<Bits>>& d) const noexcept {
+            size_t hash;
+            std::memcpy(&hash, d.get().data(), sizeof(hash));
             return hash;
         }
     };
@@ -0,0 +1,178 @@
+// Built as its own executable: it replaces the global allocator to count
+// every heap allocation made on the calling thread.
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch.hpp>
+#include <holohash/core.hpp>
+#include <cstdlib>
+#include <filesystem>
+#include <vector>
+#include <new>
+
+namespace {
+
+thread_local size_t allocations = 0;
+
+void* allocate(std::size_t size) {
+    ++allocations;
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* allocate_aligned(std::size_t size, std::align_val_t align) {
+    ++allocations;
+    const std::size_t alignment = static_cast<std::size_t>(align);
+    if (void* p = std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+// Allocations made on this thread while fn runs
+template<typename Fn>
+size_t count_allocations(Fn&& fn) {
+    const size_t before = allocations;
+    fn();
+    return allocations - before;
+}
+
+} // namespace
+
+void* operator new(std::size_t size) { return allocate(size); }
+void* operator new[](std::size_t size) { return allocate(size); }
+void* operator new(std::size_t size, std::align_val_t align) { return allocate_aligned(size, align); }
+void* operator new[](std::size_t size, std::align_val_t align) { return allocate_aligned(size, align); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    try { return allocate(size); } catch (...) { return nullptr; }
+}
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    try { return allocate(size); } catch (...) { return nullptr; }
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+
+using namespace holohash;
+
+TEST_CASE("Hot path allocations", "[alloc]") {
+    const auto now = std::chrono::system_clock::now();
+    const PackedSession session{IpAddress(std::array<uint8_t, 4>{127, 0, 0, 1}),
+                                IpAddress(std::array<uint8_t, 4>{192, 168, 1, 1}), now};
+    PackedState state;
+    state.content_hash.fill(0xC7);
+    state.cpu_load = 50.0;
+    state.memory_usage = 1024 * 1024;
+    state.timestamp = now;
+    std::array<uint8_t, 200> input{};
+    for (size_t i = 0; i < input.size(); ++i) {
+        input[i] = static_cast<uint8_t>(i * 7);
+    }
+    const std::span<const uint8_t> data(input);
+
+    // The first call on a thread may register its metrics block
+    REQUIRE(HolographicHash::try_compute(data, session));
+
+    SECTION("Hashing") {
+        for (auto version : {AlgorithmVersion::v1, AlgorithmVersion::v2}) {
+            const auto prepared = HolographicHash::prepare(session, version);
+            REQUIRE(count_allocations([&] {
+                auto hash = HolographicHash::try_compute(data, session, version);
+                REQUIRE(hash.has_value());
+            }) == 0);
+            REQUIRE(count_allocations([&] { HolographicHash::try_compute(data, prepared); }) == 0);
+            REQUIRE(count_allocations([&] { HolographicHash::compute(data, session, version); }) == 0);
+            REQUIRE(count_allocations([&] {
+                REQUIRE(HolographicHash::try_compute({}, session, version).error() == ErrorCode::empty_input);
+            }) == 0);
+        }
+    }
+
+    SECTION("Nonces") {
+        for (auto version : {AlgorithmVersion::v1, AlgorithmVersion::v2}) {
+            for (auto mode : {NonceMode::recursive, NonceMode::linear}) {
+                REQUIRE(count_allocations([&] {
+                    REQUIRE(EmergentNonce::try_generate(data, state, version, mode).has_value());
+                }) == 0);
+                REQUIRE(count_allocations([&] { EmergentNonce::generate(data, state, version, mode); }) == 0);
+                REQUIRE(count_allocations([&] {
+                    REQUIRE(EmergentNonce::try_generate({}, state, version, mode).error() == ErrorCode::empty_input);
+                }) == 0);
+            }
+        }
+    }
+
+    SECTION("Storing in a Keychain allocates, and is counted") {
+        Keychain keychain(AlgorithmVersion::v2, NonceMode::linear);
+        REQUIRE(count_allocations([&] { REQUIRE(keychain.try_generate_key(data, session, state)); }) > 0);
+    }
+
+    SECTION("Bounded flat keychain with packed contexts") {
+        KeychainOptions options;
+        options.version = AlgorithmVersion::v2;
+        options.nonce_mode = NonceMode::linear;
+        options.max_keys = 64;
+        FlatKeychain keychain(options);
+        REQUIRE(keychain.try_generate_key(data, session, state));
+
+        // Inserts, evictions and validations all run in place
+        size_t total = 0;
+        for (int i = 0; i < 1000; ++i) {
+            input[0] = static_cast<uint8_t>(i);
+            input[1] = static_cast<uint8_t>(i >> 8);
+            total += count_allocations([&] {
+                auto key = keychain.try_generate_key(data, session, state);
+                REQUIRE(key.has_value());
+                REQUIRE(keychain.validate_key(*key, session, state));
+            });
+        }
+        REQUIRE(total == 0);
+    }
+
+    SECTION("Bounded flat keychain with a snapshot attached") {
+        KeychainOptions options;
+        options.version = AlgorithmVersion::v2;
+        options.nonce_mode = NonceMode::linear;
+        const auto path = (std::filesystem::temp_directory_path() / "holohash_alloc.snapshot").string();
+        std::vector<Key> restored;
+        {
+            FlatKeychain before(options);
+            for (int i = 0; i < 256; ++i) {
+                input[0] = static_cast<uint8_t>(i);
+                input[1] = 0xFF;
+                restored.push_back(before.generate_key(data, session, state));
+            }
+            before.save_snapshot(path);
+        }
+
+        options.max_keys = 64;
+        FlatKeychain keychain(options);
+        keychain.load_snapshot(path);
+        REQUIRE(keychain.try_generate_key(data, session, state));
+
+        // Regenerated snapshot keys are evicted again, which masks their
+        // snapshot copies, and revocations mask directly
+        size_t total = 0;
+        for (int i = 0; i < 1000; ++i) {
+            input[0] = static_cast<uint8_t>(i);
+            input[1] = static_cast<uint8_t>(i % 2 == 0 ? 0xFF : i >> 8);
+            total += count_allocations([&] {
+                auto key = keychain.try_generate_key(data, session, state);
+                REQUIRE(key.has_value());
+                REQUIRE(keychain.validate_key(*key, session, state));
+            });
+        }
+        for (size_t i = 0; i < restored.size(); i += 3) {
+            total += count_allocations([&] { keychain.revoke_key(restored[i]); });
+        }
+        REQUIRE(total == 0);
+        REQUIRE(keychain.stats().evictions > 0);
+
+        std::filesystem::remove(path);
+    }
+}
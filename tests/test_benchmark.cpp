@@ -0,0 +1,72 @@
+#include <catch2/catch.hpp>
+#include <holohash/benchmark.hpp>
+#include <sstream>
+#include <thread>
+
+using namespace holohash;
+using namespace holohash::benchmark;
+
+TEST_CASE("Benchmark harness", "[benchmark]") {
+    BenchmarkOptions options;
+    options.warmup = std::chrono::milliseconds(5);
+    options.min_sample_time = std::chrono::microseconds(200);
+
+    SECTION("Short calls are batched above the sample time") {
+        uint64_t counter = 0;
+        auto result = run_benchmark("increment", 50, 8, [&] { return ++counter; }, options);
+
+        REQUIRE(result.iterations == 50);
+        REQUIRE(result.batch > 1);
+        REQUIRE(counter >= result.batch * result.iterations);
+        REQUIRE(result.ns_per_op > 0);
+        REQUIRE(result.min_time_ms * 1e6 <= result.p50_ns);
+        REQUIRE(result.p50_ns <= result.p90_ns);
+        REQUIRE(result.p90_ns <= result.p99_ns);
+        REQUIRE(result.p99_ns <= result.p999_ns);
+        REQUIRE(result.p999_ns <= result.max_time_ms * 1e6);
+        REQUIRE(result.mb_per_s > 0);
+    }
+
+    SECTION("Long calls run one per sample") {
+        auto result = run_benchmark("sleep", 3, 0, [] {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }, options);
+
+        REQUIRE(result.batch == 1);
+        REQUIRE(result.p50_ns >= 1e6);
+        REQUIRE(result.mb_per_s == 0);
+        REQUIRE(result.cycles_per_byte == 0);
+    }
+
+    SECTION("JSON round trip and baseline comparison") {
+        BenchmarkResult fast{"hash \"quoted\"", 0, 0, 0, 100, 64};
+        fast.p50_ns = 100;
+        fast.p99_ns = 150;
+        BenchmarkResult slow{"keys", 0, 0, 0, 10, 1024};
+        slow.p50_ns = 2000;
+
+        std::stringstream json;
+        write_json(json, {fast, slow});
+        auto baseline = read_json(json);
+        REQUIRE(baseline.size() == 2);
+        REQUIRE(baseline[0].name == fast.name);
+        REQUIRE(baseline[0].data_size == 64);
+        REQUIRE(baseline[0].iterations == 100);
+        REQUIRE(baseline[0].p99_ns == Approx(150));
+        REQUIRE(baseline[1].p50_ns == Approx(2000));
+
+        fast.p50_ns = 104;
+        slow.p50_ns = 2400;
+        BenchmarkResult added{"new", 0, 0, 0, 1, 64};
+        added.p50_ns = 1;
+
+        auto comparisons = compare(baseline, {fast, slow, added}, 0.05);
+        REQUIRE(comparisons.size() == 2);
+        REQUIRE_FALSE(comparisons[0].regression);
+        REQUIRE(comparisons[1].regression);
+        REQUIRE(comparisons[1].change == Approx(0.2));
+
+        std::stringstream broken("{\"benchmarks\": [{\"name\": 1}]}");
+        REQUIRE_THROWS_AS(read_json(broken), InvalidInputException);
+    }
+}
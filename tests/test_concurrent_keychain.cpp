@@ -0,0 +1,109 @@
+#include <catch2/catch.hpp>
+#include <holohash/core.hpp>
+#include <vector>
+#include <string>
+#include <thread>
+#include <atomic>
+
+using namespace holohash;
+
+TEST_CASE("ConcurrentKeychain management", "[keychain][concurrent]") {
+    std::string input = "test data";
+    std::vector<uint8_t> data(input.begin(), input.end());
+
+    SessionParams params{
+        "127.0.0.1",
+        "192.168.1.1",
+        std::chrono::system_clock::now(),
+        {}
+    };
+
+    SystemState state{
+        "content_hash",
+        50.0,
+        1024*1024,
+        std::chrono::system_clock::now(),
+        {}
+    };
+
+    SECTION("Shard count is rounded to a power of two") {
+        REQUIRE(ConcurrentKeychain(0).shard_count() == 1);
+        REQUIRE(ConcurrentKeychain(48).shard_count() == 64);
+    }
+
+    SECTION("Keys match the single-threaded keychain") {
+        ConcurrentKeychain concurrent(16, AlgorithmVersion::v2, NonceMode::linear);
+        Keychain keychain(AlgorithmVersion::v2, NonceMode::linear);
+
+        auto key = concurrent.generate_key(data, params, state);
+        REQUIRE(key == keychain.generate_key(data, params, state));
+        REQUIRE(concurrent.validate_key(key, params, state));
+
+        SessionParams different_params = params;
+        different_params.source_ip = "192.168.1.2";
+        REQUIRE_FALSE(concurrent.validate_key(key, different_params, state));
+    }
+
+    SECTION("Parallel generation and validation") {
+        ConcurrentKeychain concurrent(8, AlgorithmVersion::v2, NonceMode::linear);
+        const size_t threads = 8;
+        const size_t per_thread = 200;
+
+        std::vector<std::vector<Key>> keys(threads);
+        std::atomic<size_t> failures{0};
+        std::vector<std::thread> workers;
+
+        for (size_t t = 0; t < threads; ++t) {
+            workers.emplace_back([&, t] {
+                for (size_t i = 0; i < per_thread; ++i) {
+                    std::vector<uint8_t> payload(32, static_cast<uint8_t>(t));
+                    payload[0] = static_cast<uint8_t>(i);
+                    payload[1] = static_cast<uint8_t>(i >> 8);
+
+                    auto key = concurrent.generate_key(payload, params, state);
+                    keys[t].push_back(key);
+                    if (!concurrent.validate_key(keys[t][i / 2], params, state)) {
+                        ++failures;
+                    }
+                }
+            });
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+
+        REQUIRE(failures == 0);
+        for (const auto& thread_keys : keys) {
+            for (const auto& key : thread_keys) {
+                REQUIRE(concurrent.validate_key(key, params, state));
+            }
+        }
+    }
+
+    SECTION("Budgets are split across shards") {
+        KeychainOptions options;
+        options.version = AlgorithmVersion::v2;
+        options.nonce_mode = NonceMode::linear;
+        options.max_keys = 64;
+        ConcurrentKeychain concurrent(options, 4);
+
+        for (size_t i = 0; i < 1000; ++i) {
+            std::vector<uint8_t> payload(16, static_cast<uint8_t>(i));
+            payload[1] = static_cast<uint8_t>(i >> 8);
+            concurrent.generate_key(payload, params, state);
+        }
+
+        auto stats = concurrent.stats();
+        REQUIRE(stats.keys <= 64);
+        REQUIRE(stats.keys + stats.evictions == 1000);
+    }
+
+    SECTION("Streamed keys validate") {
+        ConcurrentKeychain concurrent;
+        Keychain::KeyStream stream(params, state);
+        stream.update(data);
+
+        auto key = concurrent.generate_key(stream);
+        REQUIRE(concurrent.validate_key(key, params, state));
+    }
+}
@@ -0,0 +1,107 @@
+#include <catch2/catch.hpp>
+#include <holohash/core.hpp>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+#include <string>
+
+using namespace holohash;
+
+namespace {
+
+std::string write_file(const std::string& name, const std::vector<uint8_t>& data) {
+    auto path = (std::filesystem::temp_directory_path() / ("holohash_" + name)).string();
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+    return path;
+}
+
+} // namespace
+
+TEST_CASE("File hashing", "[file]") {
+    SessionParams params{
+        "10.1.2.3",
+        "10.4.5.6",
+        std::chrono::system_clock::time_point{std::chrono::seconds{1700000000}},
+        {}
+    };
+
+    FileHashOptions options;
+    options.chunk_size = 16 * 1024;
+    options.queue_depth = 4;
+
+    auto make_data = [](size_t size) {
+        std::vector<uint8_t> data(size);
+        for (size_t i = 0; i < size; ++i) {
+            data[i] = static_cast<uint8_t>((i * 2654435761u) >> 11);
+        }
+        return data;
+    };
+
+    SECTION("Digests match HashStream on every backend") {
+        for (size_t size : {size_t{1}, size_t{4095}, size_t{16 * 1024}, size_t{16 * 1024 * 9 + 77}, size_t{3 << 20}}) {
+            auto data = make_data(size);
+            auto path = write_file("file_hash.bin", data);
+
+            HashStream stream(params);
+            stream.update(data);
+            const auto expected = stream.finalize();
+
+            for (bool io_uring : {true, false}) {
+                for (bool direct : {true, false}) {
+                    options.io_uring = io_uring;
+                    options.direct = direct;
+                    FileHasher hasher(options);
+                    REQUIRE(hasher.hash(path, params) == expected);
+                    // Buffers and ring are reused across files
+                    REQUIRE(hasher.hash(path, params) == expected);
+                }
+            }
+            std::filesystem::remove(path);
+        }
+    }
+
+    SECTION("Forcing pread selects the fallback") {
+        options.io_uring = false;
+        REQUIRE(FileHasher(options).backend() == FileHasher::Backend::pread);
+    }
+
+    SECTION("Asynchronous hashing") {
+        auto data = make_data(200000);
+        auto path = write_file("file_hash_async.bin", data);
+
+        HashStream stream(params);
+        stream.update(data);
+        const Hash expected = stream.finalize();
+
+        // More pending files than hashers; each is queued for one of them
+        FileHashPool pool(2, options);
+        REQUIRE(pool.size() == 2);
+        std::vector<std::future<Hash>> pending;
+        for (int i = 0; i < 16; ++i) {
+            pending.push_back(pool.submit(path, params));
+        }
+        for (auto& future : pending) {
+            REQUIRE(future.get() == expected);
+        }
+
+        auto missing = pool.submit(path + ".missing", params);
+        REQUIRE_THROWS_AS(missing.get(), FileException);
+
+        REQUIRE(FileHasher::hash_async(path, params).get() == expected);
+        std::filesystem::remove(path);
+    }
+
+    SECTION("Errors") {
+        auto missing = (std::filesystem::temp_directory_path() / "holohash_missing.bin").string();
+        std::filesystem::remove(missing);
+        REQUIRE_THROWS_AS(FileHasher(options).hash(missing, params), FileException);
+
+        auto empty = write_file("file_hash_empty.bin", {});
+        REQUIRE_THROWS_AS(FileHasher(options).hash(empty, params), InvalidInputException);
+        std::filesystem::remove(empty);
+
+        options.chunk_size = 1000;
+        REQUIRE_THROWS_AS(FileHasher(options), InvalidInputException);
+    }
+}
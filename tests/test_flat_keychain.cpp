@@ -0,0 +1,211 @@
+#include <catch2/catch.hpp>
+#include <holohash/core.hpp>
+#include <vector>
+#include <string>
+#include <random>
+
+using namespace holohash;
+
+TEST_CASE("Flat key store", "[keychain][flat]") {
+    struct Record {
+        uint64_t value;
+    };
+
+    std::mt19937_64 rng(42);
+    auto random_key = [&rng]() {
+        Key key{{}};
+        for (auto& byte : key.get()) {
+            byte = static_cast<uint8_t>(rng());
+        }
+        return key;
+    };
+
+    SECTION("Insert, find and erase across rehashes") {
+        FlatKeyStore<Record> store;
+        std::vector<Key> keys;
+        for (uint64_t i = 0; i < 10000; ++i) {
+            keys.push_back(random_key());
+            auto [slot, inserted] = store.insert(keys.back(), Record{i});
+            REQUIRE(inserted);
+            REQUIRE(store.record(slot).value == i);
+        }
+        REQUIRE(store.size() == 10000);
+        REQUIRE(store.size() <= FlatKeyStore<Record>::max_load(store.capacity()));
+
+        size_t mismatches = 0;
+        for (uint64_t i = 0; i < keys.size(); ++i) {
+            const Record* record = store.find_record(keys[i]);
+            mismatches += record == nullptr || record->value != i;
+        }
+        REQUIRE(mismatches == 0);
+        REQUIRE(store.find(random_key()) == FlatKeyStore<Record>::npos);
+
+        REQUIRE_FALSE(store.insert(keys[0], Record{99}).second);
+        REQUIRE(store.find_record(keys[0])->value == 0);
+
+        for (size_t i = 0; i < keys.size(); i += 2) {
+            REQUIRE(store.erase(keys[i]));
+        }
+        REQUIRE(store.size() == 5000);
+        for (size_t i = 0; i < keys.size(); ++i) {
+            mismatches += (store.find(keys[i]) == FlatKeyStore<Record>::npos) != (i % 2 == 0);
+        }
+        REQUIRE(mismatches == 0);
+    }
+
+    SECTION("Churn at a fixed size does not grow the table") {
+        FlatKeyStore<Record> store(1000);
+        const size_t capacity = store.capacity();
+        std::vector<Key> live;
+        for (uint64_t i = 0; i < 100000; ++i) {
+            if (live.size() == 1000) {
+                std::swap(live[rng() % live.size()], live.back());
+                REQUIRE(store.erase(live.back()));
+                live.pop_back();
+            }
+            live.push_back(random_key());
+            store.insert(live.back(), Record{i});
+        }
+        REQUIRE(store.capacity() == capacity);
+        REQUIRE(store.size() == live.size());
+
+        size_t missing = 0;
+        for (const auto& key : live) {
+            missing += store.find(key) == FlatKeyStore<Record>::npos;
+        }
+        REQUIRE(missing == 0);
+    }
+
+    SECTION("Huge pages are optional") {
+        FlatKeyStore<Record> store(1 << 16, true);
+        auto key = random_key();
+        store.insert(key, Record{7});
+        REQUIRE(store.find_record(key)->value == 7);
+        REQUIRE(store.memory_bytes() >= FlatKeyStore<Record>::bytes_for(store.capacity()));
+    }
+}
+
+TEST_CASE("Flat keychain", "[keychain][flat]") {
+    const auto now = std::chrono::system_clock::now();
+
+    SessionParams params{
+        "127.0.0.1",
+        "192.168.1.1",
+        now,
+        {}
+    };
+
+    SystemState state{
+        "content_hash",
+        50.0,
+        1024*1024,
+        now,
+        {}
+    };
+
+    auto payload = [](size_t i) {
+        std::vector<uint8_t> data(16, 0x33);
+        data[0] = static_cast<uint8_t>(i);
+        data[1] = static_cast<uint8_t>(i >> 8);
+        return data;
+    };
+
+    KeychainOptions options;
+    options.version = AlgorithmVersion::v2;
+    options.nonce_mode = NonceMode::linear;
+
+    SECTION("Keys match Keychain and validate against their context") {
+        FlatKeychain flat(options);
+        Keychain keychain(options);
+
+        auto key = flat.generate_key(payload(1), params, state);
+        REQUIRE(key == keychain.generate_key(payload(1), params, state));
+        REQUIRE(flat.validate_key(key, params, state));
+
+        SessionParams different_params = params;
+        different_params.dest_ip = "192.168.1.2";
+        REQUIRE_FALSE(flat.validate_key(key, different_params, state));
+
+        SystemState different_state = state;
+        different_state.previous_nonce = {1};
+        REQUIRE_FALSE(flat.validate_key(key, params, different_state));
+
+        REQUIRE_FALSE(flat.validate_key(keychain.generate_key(payload(2), params, state), params, state));
+    }
+
+    SECTION("Unbounded tables grow") {
+        FlatKeychain flat(options);
+        std::vector<Key> keys;
+        for (size_t i = 0; i < 2000; ++i) {
+            keys.push_back(flat.generate_key(payload(i), params, state));
+        }
+        REQUIRE(flat.size() == 2000);
+
+        size_t invalid = 0;
+        for (const auto& key : keys) {
+            invalid += !flat.validate_key(key, params, state);
+        }
+        REQUIRE(invalid == 0);
+    }
+
+    SECTION("Key budget evicts") {
+        options.max_keys = 100;
+        FlatKeychain flat(options);
+        const size_t capacity = flat.capacity();
+        for (size_t i = 0; i < 1000; ++i) {
+            flat.generate_key(payload(i), params, state);
+        }
+
+        auto stats = flat.stats();
+        REQUIRE(stats.keys == 100);
+        REQUIRE(stats.evictions == 900);
+        REQUIRE(flat.capacity() == capacity);
+    }
+
+    SECTION("Recently validated keys get a second chance") {
+        options.max_keys = 10;
+        FlatKeychain flat(options);
+        std::vector<Key> keys;
+        for (size_t i = 0; i < 10; ++i) {
+            keys.push_back(flat.generate_key(payload(i), params, state));
+        }
+        for (size_t i = 1; i < keys.size(); ++i) {
+            REQUIRE(flat.validate_key(keys[i], params, state));
+        }
+
+        flat.generate_key(payload(10), params, state);
+        REQUIRE(flat.stats().evictions == 1);
+        REQUIRE_FALSE(flat.validate_key(keys[0], params, state));
+    }
+
+    SECTION("Byte budget bounds the table") {
+        options.max_bytes = 64 * 1024;
+        FlatKeychain flat(options);
+        for (size_t i = 0; i < 5000; ++i) {
+            flat.generate_key(payload(i), params, state);
+        }
+
+        auto stats = flat.stats();
+        REQUIRE(stats.bytes <= options.max_bytes);
+        REQUIRE(stats.keys > 0);
+        REQUIRE(stats.evictions + stats.keys == 5000);
+    }
+
+    SECTION("Keys expire after their TTL") {
+        options.ttl = std::chrono::hours(1);
+        FlatKeychain flat(options);
+
+        auto live = flat.generate_key(payload(1), params, state);
+        REQUIRE(flat.validate_key(live, params, state));
+
+        SessionParams stale = params;
+        stale.timestamp = now - std::chrono::hours(2);
+        auto dead = flat.generate_key(payload(2), stale, state);
+        REQUIRE_FALSE(flat.validate_key(dead, stale, state));
+        REQUIRE(flat.stats().expirations == 1);
+
+        flat.expire(now + std::chrono::hours(2));
+        REQUIRE(flat.size() == 0);
+        REQUIRE(flat.stats().expirations == 2);
+    }
+}
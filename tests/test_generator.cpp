@@ -0,0 +1,71 @@
+#include <catch2/catch.hpp>
+#include <holohash/generator.hpp>
+#include <random>
+#include <vector>
+
+using namespace holohash;
+
+TEST_CASE("Multiply-shift helpers", "[generator]") {
+    static_assert(detail::mul_hi64(~0ULL, ~0ULL) == 0xFFFFFFFFFFFFFFFEULL);
+    static_assert(detail::mul_hi64(1ULL << 32, 1ULL << 32) == 1);
+    static_assert(detail::mul_hi64(0x123456789ABCDEF0ULL, 0) == 0);
+
+    REQUIRE(detail::mul_hi64(0xFEDCBA9876543210ULL, 0x0123456789ABCDEFULL) == 0x0121FA00AD77D742ULL);
+
+    const uint8_t bytes[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+    REQUIRE(detail::load_le64(bytes) == 0x0807060504030201ULL);
+}
+
+TEST_CASE("Constexpr Mersenne Twister", "[generator]") {
+    // 10000th output of a default-seeded mt19937_64, per the standard
+    static_assert([] {
+        detail::Mt19937_64 rng(5489);
+        uint64_t value = 0;
+        for (int i = 0; i < 10000; ++i) {
+            value = rng();
+        }
+        return value;
+    }() == 9981545732273789042ULL);
+
+    for (uint64_t seed : {0ULL, 1ULL, 0x0123456789ABCDEFULL, ~0ULL}) {
+        detail::Mt19937_64 ours(seed);
+        std::mt19937_64 standard(seed);
+        for (int i = 0; i < 1000; ++i) {
+            REQUIRE(ours() == standard());
+        }
+    }
+}
+
+TEST_CASE("CounterGenerator", "[generator]") {
+    const std::array<uint8_t, 16> seed = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16};
+
+    SECTION("Sequences are reproducible") {
+        CounterGenerator a(seed);
+        CounterGenerator b(seed);
+        for (int i = 0; i < 100; ++i) {
+            REQUIRE(a.next() == b.next());
+        }
+    }
+
+    SECTION("Indices stay within bound and cover the range") {
+        CounterGenerator gen(seed);
+        std::vector<size_t> counts(7, 0);
+        for (int i = 0; i < 7000; ++i) {
+            size_t idx = gen(counts.size());
+            REQUIRE(idx < counts.size());
+            ++counts[idx];
+        }
+        for (size_t count : counts) {
+            REQUIRE(count > 800);
+            REQUIRE(count < 1200);
+        }
+    }
+
+    SECTION("Different seeds give different sequences") {
+        auto other = seed;
+        other[15] ^= 1;
+        CounterGenerator a(seed);
+        CounterGenerator b(other);
+        REQUIRE(a.next() != b.next());
+    }
+}
@@ -3,9 +3,17 @@
 #include <holohash/core.hpp>
 #include <vector>
 #include <string>
+#include <unordered_set>
 
 using namespace holohash;
 
+TEST_CASE("Digest storage is vector aligned", "[hash]") {
+    STATIC_REQUIRE(alignof(Hash) == 32);
+    STATIC_REQUIRE(alignof(Key) == 32);
+    STATIC_REQUIRE(alignof(Nonce) == 16);
+    STATIC_REQUIRE(sizeof(Hash) == 32);
+}
+
 TEST_CASE("HolographicHash basic functionality", "[hash]") {
     std::string input = "test data";
     SessionParams params{
@@ -39,4 +47,460 @@ TEST_CASE("HolographicHash basic functionality", "[hash]") {
 
         REQUIRE(hash1.get() != hash2.get());
     }
+
+    SECTION("Non-throwing variant") {
+        std::vector<uint8_t> data(input.begin(), input.end());
+        for (auto version : {AlgorithmVersion::v1, AlgorithmVersion::v2}) {
+            auto hash = HolographicHash::try_compute(data, params, version);
+            REQUIRE(hash.has_value());
+            REQUIRE(*hash == HolographicHash::compute(data, params, version));
+            REQUIRE(*HolographicHash::try_compute(data, HolographicHash::prepare(params, version)) == *hash);
+        }
+
+        auto failed = HolographicHash::try_compute({}, params);
+        REQUIRE_FALSE(failed);
+        REQUIRE(failed.error() == ErrorCode::empty_input);
+        REQUIRE(failed.value_or(Hash{{}}) == Hash{{}});
+        static_assert(noexcept(HolographicHash::try_compute({}, params)));
+    }
+}
+
+TEST_CASE("HashStream incremental hashing", "[hash][stream]") {
+    SessionParams params{
+        "127.0.0.1",
+        "192.168.1.1",
+        std::chrono::system_clock::now(),
+        {}
+    };
+
+    std::vector<uint8_t> data(3 * HashStream::block_size + 123);
+    for (size_t i = 0; i < data.size(); ++i) {
+        data[i] = static_cast<uint8_t>(i * 7 + 1);
+    }
+
+    SECTION("Digest does not depend on chunking") {
+        HashStream whole(params);
+        whole.update(data);
+
+        for (size_t chunk : {size_t{1}, size_t{17}, size_t{1000}, HashStream::block_size + 1}) {
+            HashStream pieces(params);
+            for (size_t off = 0; off < data.size(); off += chunk) {
+                pieces.update(std::span<const uint8_t>(data).subspan(off, std::min(chunk, data.size() - off)));
+            }
+            REQUIRE(pieces.size() == data.size());
+            REQUIRE(pieces.finalize().get() == whole.finalize().get());
+        }
+    }
+
+    SECTION("Finalize does not consume the stream") {
+        HashStream stream(params);
+        stream.update(data);
+        REQUIRE(stream.finalize().get() == stream.finalize().get());
+    }
+
+    SECTION("Length is bound into the digest") {
+        std::vector<uint8_t> block(HashStream::block_size, 0);
+        HashStream one(params);
+        one.update(block);
+        HashStream two(params);
+        two.update(block);
+        two.update(block);
+        REQUIRE(one.finalize().get() != two.finalize().get());
+    }
+
+    SECTION("Empty stream throws exception") {
+        HashStream stream(params);
+        REQUIRE_THROWS_AS(stream.finalize(), InvalidInputException);
+    }
+}
+
+TEST_CASE("HolographicHash batch computation", "[hash][batch]") {
+    const auto now = std::chrono::system_clock::now();
+
+    std::vector<std::vector<uint8_t>> messages;
+    std::vector<SessionParams> params;
+    for (size_t i = 0; i < 37; ++i) {
+        std::vector<uint8_t> msg(1 + (i * 29) % 512);
+        for (size_t j = 0; j < msg.size(); ++j) {
+            msg[j] = static_cast<uint8_t>(i * 31 + j);
+        }
+        messages.push_back(std::move(msg));
+        params.push_back(SessionParams{
+            "10.0.0." + std::to_string(i),
+            "192.168.1.1",
+            now + std::chrono::seconds(i),
+            {}
+        });
+    }
+
+    std::vector<std::span<const uint8_t>> inputs(messages.begin(), messages.end());
+
+    SECTION("Batch digests match scalar digests") {
+        std::vector<Hash> out(inputs.size(), Hash{{}});
+        HolographicHash::compute_batch(inputs, params, out);
+
+        for (size_t i = 0; i < inputs.size(); ++i) {
+            REQUIRE(out[i].get() == HolographicHash::compute(inputs[i], params[i]).get());
+        }
+    }
+
+    SECTION("Mismatched lengths throw exception") {
+        std::vector<Hash> out(inputs.size() - 1, Hash{{}});
+        REQUIRE_THROWS_AS(
+            HolographicHash::compute_batch(inputs, params, out),
+            InvalidInputException
+        );
+    }
+
+    SECTION("Empty member input throws exception") {
+        inputs[5] = {};
+        std::vector<Hash> out(inputs.size(), Hash{{}});
+        REQUIRE_THROWS_AS(
+            HolographicHash::compute_batch(inputs, params, out),
+            InvalidInputException
+        );
+    }
+}
+
+TEST_CASE("HolographicHash v2 output specification", "[hash][v2]") {
+    std::string input = "holographic";
+    std::vector<uint8_t> data(input.begin(), input.end());
+    SessionParams params{
+        "10.1.2.3",
+        "10.4.5.6",
+        std::chrono::system_clock::time_point{std::chrono::seconds{1700000000}},
+        {}
+    };
+
+    SECTION("Known answer") {
+        const std::array<uint8_t, 32> expected = {
+            0xab, 0xa3, 0x60, 0xdb, 0xda, 0x4d, 0x2f, 0x8d,
+            0xa9, 0x82, 0x93, 0x7a, 0xbf, 0x7f, 0x48, 0x19,
+            0x53, 0xe7, 0xf0, 0xe2, 0x44, 0x06, 0x79, 0xe8,
+            0xa9, 0xe2, 0x22, 0x44, 0xf0, 0x97, 0x50, 0x0f
+        };
+        REQUIRE(HolographicHash::compute(data, params, AlgorithmVersion::v2).get() == expected);
+    }
+
+    SECTION("Digest does not depend on the kernel level") {
+        const auto original = platform::active_simd_level();
+        const auto expected = HolographicHash::compute(data, params, AlgorithmVersion::v2).get();
+        for (auto level : {platform::SimdLevel::scalar, platform::SimdLevel::sse2,
+                           platform::SimdLevel::avx2, platform::SimdLevel::avx512}) {
+            platform::set_simd_level(level);
+            REQUIRE(HolographicHash::compute(data, params, AlgorithmVersion::v2).get() == expected);
+        }
+        platform::set_simd_level(original);
+    }
+
+    SECTION("Versions are distinct") {
+        REQUIRE(HolographicHash::compute(data, params, AlgorithmVersion::v1).get() !=
+                HolographicHash::compute(data, params, AlgorithmVersion::v2).get());
+    }
+
+    SECTION("Whole IPv6 addresses and the address family are hashed") {
+        // 2001:db8::1 and 2001:db8::2 share their first 4 bytes
+        PackedSession first{IpAddress(std::array<uint8_t, 16>{0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1}),
+                            IpAddress(std::array<uint8_t, 4>{10, 4, 5, 6}), params.timestamp};
+        PackedSession second = first;
+        second.source_ip.bytes[15] = 2;
+        REQUIRE(HolographicHash::compute(data, first, AlgorithmVersion::v2) !=
+                HolographicHash::compute(data, second, AlgorithmVersion::v2));
+        REQUIRE(HolographicHash::compute(data, first, AlgorithmVersion::v1) ==
+                HolographicHash::compute(data, second, AlgorithmVersion::v1));
+
+        // The IPv4 address equal to the first 4 bytes of the IPv6 one
+        PackedSession v4 = first;
+        v4.source_ip = IpAddress(std::array<uint8_t, 4>{0x20, 0x01, 0x0d, 0xb8});
+        REQUIRE(HolographicHash::compute(data, first, AlgorithmVersion::v2) !=
+                HolographicHash::compute(data, v4, AlgorithmVersion::v2));
+
+        second = first;
+        second.dest_ip = IpAddress(std::array<uint8_t, 16>{0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1});
+        PackedSession third = second;
+        third.dest_ip.bytes[8] = 0xFF;
+        REQUIRE(HolographicHash::compute(data, second, AlgorithmVersion::v2) !=
+                HolographicHash::compute(data, third, AlgorithmVersion::v2));
+    }
+
+    SECTION("Batch matches scalar") {
+        std::vector<std::span<const uint8_t>> inputs(20, std::span<const uint8_t>(data));
+        std::vector<SessionParams> batch_params(20, params);
+        for (size_t i = 0; i < batch_params.size(); ++i) {
+            batch_params[i].timestamp += std::chrono::seconds(i);
+        }
+        std::vector<Hash> out(20, Hash{{}});
+        HolographicHash::compute_batch(inputs, batch_params, out, AlgorithmVersion::v2);
+
+        for (size_t i = 0; i < out.size(); ++i) {
+            REQUIRE(out[i].get() == HolographicHash::compute(data, batch_params[i], AlgorithmVersion::v2).get());
+        }
+    }
+}
+
+TEST_CASE("Prepared sessions", "[hash][prepared]") {
+    STATIC_REQUIRE(std::is_trivially_copyable_v<PreparedSession>);
+    STATIC_REQUIRE(sizeof(PreparedSession) == 32);
+
+    SessionParams params{
+        "10.1.2.3",
+        "10.4.5.6",
+        std::chrono::system_clock::time_point{std::chrono::seconds{1700000000}},
+        {}
+    };
+
+    std::vector<std::vector<uint8_t>> messages;
+    for (size_t size : {1, 7, 32, 100, 4096}) {
+        messages.emplace_back(size, static_cast<uint8_t>(size));
+    }
+
+    SECTION("Digests match unprepared hashing") {
+        for (auto version : {AlgorithmVersion::v1, AlgorithmVersion::v2}) {
+            const auto session = HolographicHash::prepare(params, version);
+            REQUIRE(session.version() == version);
+            for (const auto& message : messages) {
+                REQUIRE(HolographicHash::compute(message, session).get() ==
+                        HolographicHash::compute(message, params, version).get());
+            }
+        }
+    }
+
+    SECTION("Default session is the empty context at the epoch") {
+        SessionParams empty{"", "", std::chrono::system_clock::time_point{}, {}};
+        REQUIRE(PreparedSession{} == HolographicHash::prepare(empty));
+    }
+
+    SECTION("Batch matches scalar") {
+        std::vector<std::span<const uint8_t>> inputs(messages.begin(), messages.end());
+        std::vector<PreparedSession> sessions;
+        for (size_t i = 0; i < inputs.size(); ++i) {
+            SessionParams lane = params;
+            lane.timestamp += std::chrono::seconds(i);
+            sessions.push_back(HolographicHash::prepare(lane, AlgorithmVersion::v2));
+        }
+        std::vector<Hash> out(inputs.size(), Hash{{}});
+        HolographicHash::compute_batch(inputs, sessions, out);
+
+        for (size_t i = 0; i < out.size(); ++i) {
+            REQUIRE(out[i].get() == HolographicHash::compute(inputs[i], sessions[i]).get());
+        }
+
+        sessions[1] = HolographicHash::prepare(params, AlgorithmVersion::v1);
+        REQUIRE_THROWS_AS(HolographicHash::compute_batch(inputs, sessions, out), InvalidInputException);
+    }
+
+    SECTION("Empty input throws exception") {
+        std::vector<uint8_t> empty;
+        REQUIRE_THROWS_AS(HolographicHash::compute(empty, HolographicHash::prepare(params)), InvalidInputException);
+    }
+}
+
+namespace {
+
+constexpr auto constant_message = literal_bytes("holographic");
+constexpr auto constant_long_message = literal_bytes("tenant-0042/routes/orders/v3/items/by-customer");
+constexpr auto constant_source = literal_bytes("10.1.2.3");
+constexpr auto constant_dest = literal_bytes("10.4.5.6");
+constexpr std::chrono::system_clock::time_point constant_time{std::chrono::seconds{1700000000}};
+
+constexpr Hash constant_digest(std::span<const uint8_t> message, AlgorithmVersion version) {
+    return HolographicHash::compute(message, SessionView(constant_source, constant_dest, constant_time), version);
+}
+
+} // namespace
+
+TEST_CASE("Compile-time hashing", "[hash][constexpr]") {
+    constexpr Hash v1 = constant_digest(constant_message, AlgorithmVersion::v1);
+    constexpr Hash v2 = constant_digest(constant_message, AlgorithmVersion::v2);
+    constexpr Hash v1_long = constant_digest(constant_long_message, AlgorithmVersion::v1);
+    constexpr Hash v2_long = constant_digest(constant_long_message, AlgorithmVersion::v2);
+
+    // Same known answer as the runtime v2 specification
+    STATIC_REQUIRE(v2.get() == std::array<uint8_t, 32>{
+        0xab, 0xa3, 0x60, 0xdb, 0xda, 0x4d, 0x2f, 0x8d,
+        0xa9, 0x82, 0x93, 0x7a, 0xbf, 0x7f, 0x48, 0x19,
+        0x53, 0xe7, 0xf0, 0xe2, 0x44, 0x06, 0x79, 0xe8,
+        0xa9, 0xe2, 0x22, 0x44, 0xf0, 0x97, 0x50, 0x0f
+    });
+    STATIC_REQUIRE(v1 != v2);
+    STATIC_REQUIRE(literal_bytes("abc") == std::array<uint8_t, 3>{'a', 'b', 'c'});
+
+    SessionParams params{
+        "10.1.2.3",
+        "10.4.5.6",
+        std::chrono::system_clock::time_point{std::chrono::seconds{1700000000}},
+        {}
+    };
+
+    SECTION("Compile-time digests equal runtime digests") {
+        std::vector<uint8_t> data(constant_message.begin(), constant_message.end());
+        std::vector<uint8_t> long_data(constant_long_message.begin(), constant_long_message.end());
+        REQUIRE(HolographicHash::compute(data, params, AlgorithmVersion::v1) == v1);
+        REQUIRE(HolographicHash::compute(data, params, AlgorithmVersion::v2) == v2);
+        REQUIRE(HolographicHash::compute(long_data, params, AlgorithmVersion::v1) == v1_long);
+        REQUIRE(HolographicHash::compute(long_data, params, AlgorithmVersion::v2) == v2_long);
+    }
+
+    SECTION("Prepared sessions at compile time") {
+        constexpr auto session = HolographicHash::prepare(
+            SessionView(constant_source, constant_dest, constant_time), AlgorithmVersion::v2);
+        STATIC_REQUIRE(HolographicHash::compute(constant_message, session) == v2);
+        REQUIRE(session == HolographicHash::prepare(params, AlgorithmVersion::v2));
+
+        constexpr Hash empty_context = HolographicHash::compute(constant_message, PreparedSession{});
+        SessionParams empty{"", "", std::chrono::system_clock::time_point{}, {}};
+        REQUIRE(HolographicHash::compute(constant_message, empty) == empty_context);
+    }
+}
+
+TEST_CASE("Hash profiles", "[hash][profile]") {
+    STATIC_REQUIRE(std::is_same_v<StandardHash::Digest, Hash>);
+    STATIC_REQUIRE(sizeof(FastHash::Digest) == 16);
+    STATIC_REQUIRE(sizeof(StrongHash::Digest) == 64);
+    STATIC_REQUIRE(alignof(StrongHash::Digest) == 64);
+
+    SessionParams params{
+        "10.1.2.3",
+        "10.4.5.6",
+        std::chrono::system_clock::time_point{std::chrono::seconds{1700000000}},
+        {}
+    };
+
+    std::vector<std::vector<uint8_t>> messages;
+    for (size_t size : {1, 7, 16, 64, 1000}) {
+        std::vector<uint8_t> message(size);
+        for (size_t i = 0; i < size; ++i) {
+            message[i] = static_cast<uint8_t>(i * 31 + size);
+        }
+        messages.push_back(std::move(message));
+    }
+
+    SECTION("Standard profile is HolographicHash") {
+        for (auto version : {AlgorithmVersion::v1, AlgorithmVersion::v2}) {
+            for (const auto& message : messages) {
+                REQUIRE(StandardHash::compute(message, params, version) ==
+                        HolographicHash::compute(message, params, version));
+            }
+        }
+    }
+
+    SECTION("Digests are deterministic and depend on input, context and version") {
+        for (auto version : {AlgorithmVersion::v1, AlgorithmVersion::v2}) {
+            const auto session = HolographicHash::prepare(params, version);
+            for (const auto& message : messages) {
+                REQUIRE(FastHash::compute(message, params, version) == FastHash::compute(message, session));
+                REQUIRE(StrongHash::compute(message, params, version) == StrongHash::compute(message, session));
+            }
+        }
+
+        auto other = messages[3];
+        other[0] ^= 1;
+        REQUIRE(FastHash::compute(messages[3], params) != FastHash::compute(other, params));
+        REQUIRE(StrongHash::compute(messages[3], params) != StrongHash::compute(other, params));
+
+        SessionParams later = params;
+        later.timestamp += std::chrono::seconds(1);
+        REQUIRE(FastHash::compute(messages[3], params) != FastHash::compute(messages[3], later));
+        REQUIRE(FastHash::compute(messages[3], params, AlgorithmVersion::v1) !=
+                FastHash::compute(messages[3], params, AlgorithmVersion::v2));
+    }
+
+    SECTION("Profiles are distinct transforms") {
+        const auto fast = FastHash::compute(messages[3], params);
+        const auto standard = StandardHash::compute(messages[3], params);
+        const auto strong = StrongHash::compute(messages[3], params);
+        REQUIRE_FALSE(std::equal(fast.get().begin(), fast.get().end(), standard.get().begin()));
+        REQUIRE_FALSE(std::equal(standard.get().begin(), standard.get().end(), strong.get().begin()));
+    }
+
+    SECTION("Profiles run at compile time") {
+        constexpr auto fast = FastHash::compute(constant_message,
+            SessionView(constant_source, constant_dest, constant_time), AlgorithmVersion::v2);
+        constexpr auto strong = StrongHash::compute(constant_message,
+            SessionView(constant_source, constant_dest, constant_time), AlgorithmVersion::v2);
+        std::vector<uint8_t> data(constant_message.begin(), constant_message.end());
+        REQUIRE(FastHash::compute(data, params, AlgorithmVersion::v2) == fast);
+        REQUIRE(StrongHash::compute(data, params, AlgorithmVersion::v2) == strong);
+    }
+
+    SECTION("Empty input") {
+        std::vector<uint8_t> empty;
+        REQUIRE_THROWS_AS(FastHash::compute(empty, params), InvalidInputException);
+        REQUIRE(FastHash::try_compute(empty, params).error() == ErrorCode::empty_input);
+        REQUIRE(*FastHash::try_compute(messages[0], params) == FastHash::compute(messages[0], params));
+    }
+
+    SECTION("Digests key unordered containers") {
+        std::unordered_set<FastHash::Digest> seen;
+        for (const auto& message : messages) {
+            seen.insert(FastHash::compute(message, params));
+        }
+        REQUIRE(seen.size() == messages.size());
+    }
+}
+
+TEST_CASE("HolographicHash tree mode", "[hash][tree]") {
+    SessionParams params{
+        "10.1.2.3",
+        "10.4.5.6",
+        std::chrono::system_clock::time_point{std::chrono::seconds{1700000000}},
+        {}
+    };
+
+    std::vector<uint8_t> data(1 << 20);
+    for (size_t i = 0; i < data.size(); ++i) {
+        data[i] = static_cast<uint8_t>(i * 2654435761u >> 13);
+    }
+
+    TreeParams tree;
+    tree.chunk_size = 64 * 1024;
+
+    SECTION("Digest does not depend on the thread count") {
+        ThreadPool single(1);
+        ThreadPool many(7);
+        const auto expected = HolographicHash::compute_tree(data, params, tree);
+
+        tree.pool = &single;
+        REQUIRE(HolographicHash::compute_tree(data, params, tree) == expected);
+        tree.pool = &many;
+        REQUIRE(HolographicHash::compute_tree(data, params, tree) == expected);
+    }
+
+    SECTION("Chunk size and length are bound into the digest") {
+        const auto expected = HolographicHash::compute_tree(data, params, tree);
+
+        TreeParams other = tree;
+        other.chunk_size = 128 * 1024;
+        REQUIRE(HolographicHash::compute_tree(data, params, other) != expected);
+
+        std::span<const uint8_t> prefix(data.data(), data.size() - 1);
+        REQUIRE(HolographicHash::compute_tree(prefix, params, tree) != expected);
+
+        HashStream stream(params);
+        stream.update(data);
+        REQUIRE(stream.finalize() != expected);
+    }
+
+    SECTION("Every leaf and the session contribute") {
+        const auto expected = HolographicHash::compute_tree(data, params, tree);
+        for (size_t leaf : {size_t{0}, size_t{7}, size_t{15}}) {
+            auto changed = data;
+            changed[leaf * tree.chunk_size] ^= 1;
+            REQUIRE(HolographicHash::compute_tree(changed, params, tree) != expected);
+        }
+
+        SessionParams other = params;
+        other.source_ip = "11.1.2.3";
+        REQUIRE(HolographicHash::compute_tree(data, other, tree) != expected);
+    }
+
+    SECTION("Invalid parameters throw") {
+        std::vector<uint8_t> empty;
+        REQUIRE_THROWS_AS(HolographicHash::compute_tree(empty, params, tree), InvalidInputException);
+
+        tree.chunk_size = 1000;
+        REQUIRE_THROWS_AS(HolographicHash::compute_tree(data, params, tree), InvalidInputException);
+        tree.chunk_size = 0;
+        REQUIRE_THROWS_AS(HolographicHash::compute_tree(data, params, tree), InvalidInputException);
+    }
 }
@@ -0,0 +1,237 @@
+#include <catch2/catch.hpp>
+#include <holohash/core.hpp>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <thread>
+#if defined(__linux__)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace holohash;
+
+namespace {
+
+std::string temp_path(const std::string& name) {
+    auto path = std::filesystem::temp_directory_path() / ("holohash_" + name);
+    std::filesystem::remove(path);
+    return path.string();
+}
+
+} // namespace
+
+TEST_CASE("Key log", "[keychain][log]") {
+    const auto now = std::chrono::system_clock::now();
+
+    SessionParams params{
+        "127.0.0.1",
+        "192.168.1.1",
+        now,
+        {}
+    };
+
+    SystemState state{
+        "content_hash",
+        50.0,
+        1024*1024,
+        now,
+        {}
+    };
+
+    auto payload = [](size_t i) {
+        std::vector<uint8_t> data(16, 0x6B);
+        data[0] = static_cast<uint8_t>(i);
+        data[1] = static_cast<uint8_t>(i >> 8);
+        return data;
+    };
+
+    KeychainOptions options;
+    options.version = AlgorithmVersion::v2;
+    options.nonce_mode = NonceMode::linear;
+
+    SECTION("Replay rebuilds the keychain") {
+        auto path = temp_path("replay.wal");
+        std::vector<Key> keys;
+        {
+            FlatKeychain before(options);
+            before.attach_log(std::make_shared<KeyLog>(path));
+            for (size_t i = 0; i < 1000; ++i) {
+                keys.push_back(before.generate_key(payload(i), params, state));
+            }
+            REQUIRE(before.revoke_key(keys[3]));
+            REQUIRE_FALSE(before.revoke_key(keys[3]));
+
+            REQUIRE(before.log()->appended() == 1001);
+            before.log()->flush();
+            // Group commit: far fewer writes than entries
+            REQUIRE(before.log()->groups_written() < 1001);
+        }
+
+        FlatKeychain after(options);
+        REQUIRE(after.replay_log(path) == 1001);
+        REQUIRE(after.size() == 999);
+
+        size_t mismatches = 0;
+        for (size_t i = 0; i < keys.size(); ++i) {
+            mismatches += after.validate_key(keys[i], params, state) != (i != 3);
+        }
+        REQUIRE(mismatches == 0);
+
+        std::filesystem::remove(path);
+    }
+
+    SECTION("Evictions are replayed") {
+        auto path = temp_path("evict.wal");
+        options.max_keys = 10;
+        std::vector<Key> keys;
+        {
+            FlatKeychain before(options);
+            before.attach_log(std::make_shared<KeyLog>(path));
+            for (size_t i = 0; i < 50; ++i) {
+                keys.push_back(before.generate_key(payload(i), params, state));
+            }
+            REQUIRE(before.stats().evictions == 40);
+        }
+
+        options.max_keys = 0;
+        FlatKeychain after(options);
+        REQUIRE(after.replay_log(path) == 90);
+        REQUIRE(after.size() == 10);
+
+        std::filesystem::remove(path);
+    }
+
+    SECTION("A torn tail ends the replay") {
+        auto path = temp_path("torn.wal");
+        {
+            FlatKeychain before(options);
+            before.attach_log(std::make_shared<KeyLog>(path));
+            for (size_t i = 0; i < 10; ++i) {
+                before.generate_key(payload(i), params, state);
+            }
+        }
+
+        const auto size = std::filesystem::file_size(path);
+        {
+            std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+            file.seekp(static_cast<std::streamoff>(size - sizeof(KeyLog::Entry) + 20));
+            file.put('\x55');
+        }
+        {
+            std::ofstream out(path, std::ios::binary | std::ios::app);
+            out << std::string(30, 'x');
+        }
+
+        FlatKeychain after(options);
+        REQUIRE(after.replay_log(path) == 9);
+        REQUIRE(after.size() == 9);
+
+        // Reopening drops the damaged tail and appends after the intact entries
+        {
+            KeyLog log(path);
+            REQUIRE(std::filesystem::file_size(path) == size - sizeof(KeyLog::Entry));
+            log.append(KeyLog::Op::evict, Key{{}}.get().data(), KeyRecord{});
+        }
+        REQUIRE(KeyLog::replay(path, [](const KeyLog::Entry&) {}) == 10);
+
+        std::filesystem::remove(path);
+    }
+
+    SECTION("Snapshot plus log covers every key") {
+        auto snapshot = temp_path("base.snapshot");
+        auto path = temp_path("since.wal");
+        std::vector<Key> keys;
+        {
+            FlatKeychain before(options);
+            before.attach_log(std::make_shared<KeyLog>(path));
+            for (size_t i = 0; i < 100; ++i) {
+                keys.push_back(before.generate_key(payload(i), params, state));
+            }
+            before.save_snapshot(snapshot);
+            before.log()->truncate();
+
+            for (size_t i = 100; i < 150; ++i) {
+                keys.push_back(before.generate_key(payload(i), params, state));
+            }
+            REQUIRE(before.revoke_key(keys[0]));
+        }
+
+        FlatKeychain after(options);
+        after.load_snapshot(snapshot);
+        REQUIRE(after.replay_log(path) == 51);
+
+        size_t mismatches = 0;
+        for (size_t i = 0; i < keys.size(); ++i) {
+            mismatches += after.validate_key(keys[i], params, state) != (i != 0);
+        }
+        REQUIRE(mismatches == 0);
+
+        std::filesystem::remove(snapshot);
+        std::filesystem::remove(path);
+    }
+
+#if defined(__linux__)
+    SECTION("A failed write does not hang the writer") {
+        auto path = temp_path("failing.wal");
+        KeyLogOptions log_options;
+        log_options.flush_interval = std::chrono::microseconds(1);
+        auto* log = new KeyLog(path, log_options);
+
+        // Point the log's descriptor at /dev/full, so the next group fails
+        const auto target = std::filesystem::canonical(path);
+        int log_fd = -1;
+        for (const auto& entry : std::filesystem::directory_iterator("/proc/self/fd")) {
+            std::error_code error;
+            if (std::filesystem::read_symlink(entry.path(), error) == target) {
+                log_fd = std::stoi(entry.path().filename().string());
+            }
+        }
+        REQUIRE(log_fd >= 0);
+        const int full = ::open("/dev/full", O_WRONLY);
+        REQUIRE(full >= 0);
+        REQUIRE(::dup2(full, log_fd) == log_fd);
+        ::close(full);
+
+        // Appends race the writer's failure; those that get past the check
+        // must not keep it alive
+        size_t rejected = 0;
+        for (size_t i = 0; i < 100000; ++i) {
+            try {
+                log->append(KeyLog::Op::evict, Key{{}}.get().data(), KeyRecord{});
+            } catch (const KeychainException&) {
+                ++rejected;
+            }
+        }
+        REQUIRE(rejected > 0);
+        REQUIRE_THROWS_AS(log->flush(), KeychainException);
+
+        // Leaked rather than joined on the test thread if it does hang
+        auto destroyed = std::make_shared<std::atomic<bool>>(false);
+        std::thread([log, destroyed] {
+            delete log;
+            *destroyed = true;
+        }).detach();
+        for (int i = 0; i < 500 && !*destroyed; ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        REQUIRE(*destroyed);
+
+        std::filesystem::remove(path);
+    }
+#endif
+
+    SECTION("Other files are rejected") {
+        auto path = temp_path("other.wal");
+        {
+            std::ofstream out(path, std::ios::binary);
+            out << std::string(100, 'x');
+        }
+        REQUIRE_THROWS_AS(KeyLog(path), KeychainException);
+        REQUIRE_THROWS_AS(FlatKeychain(options).replay_log(path), KeychainException);
+        REQUIRE(FlatKeychain(options).replay_log(temp_path("missing.wal")) == 0);
+
+        std::filesystem::remove(path);
+    }
+}
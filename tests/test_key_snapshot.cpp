@@ -0,0 +1,215 @@
+#include <catch2/catch.hpp>
+#include <holohash/core.hpp>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+#include <string>
+
+using namespace holohash;
+
+namespace {
+
+std::string snapshot_path(const std::string& name) {
+    auto path = std::filesystem::temp_directory_path() / ("holohash_" + name + ".snapshot");
+    std::filesystem::remove(path);
+    return path.string();
+}
+
+} // namespace
+
+TEST_CASE("Key snapshots", "[keychain][snapshot]") {
+    const auto now = std::chrono::system_clock::now();
+
+    SessionParams params{
+        "127.0.0.1",
+        "192.168.1.1",
+        now,
+        {}
+    };
+
+    SystemState state{
+        "content_hash",
+        50.0,
+        1024*1024,
+        now,
+        {}
+    };
+
+    auto payload = [](size_t i) {
+        std::vector<uint8_t> data(16, 0x5A);
+        data[0] = static_cast<uint8_t>(i);
+        data[1] = static_cast<uint8_t>(i >> 8);
+        return data;
+    };
+
+    KeychainOptions options;
+    options.version = AlgorithmVersion::v2;
+    options.nonce_mode = NonceMode::linear;
+
+    SECTION("Keys survive a restart") {
+        auto path = snapshot_path("restart");
+        std::vector<Key> keys;
+        {
+            FlatKeychain before(options);
+            for (size_t i = 0; i < 500; ++i) {
+                keys.push_back(before.generate_key(payload(i), params, state));
+            }
+            before.save_snapshot(path);
+        }
+
+        FlatKeychain after(options);
+        after.load_snapshot(path);
+        REQUIRE(after.size() == 0);
+        REQUIRE(after.snapshot()->size() == 500);
+        REQUIRE(after.snapshot()->version() == AlgorithmVersion::v2);
+
+        size_t invalid = 0;
+        for (const auto& key : keys) {
+            invalid += !after.validate_key(key, params, state);
+        }
+        REQUIRE(invalid == 0);
+
+        SessionParams different_params = params;
+        different_params.source_ip = "10.0.0.1";
+        REQUIRE_FALSE(after.validate_key(keys[0], different_params, state));
+        REQUIRE_FALSE(after.validate_key(Key{{}}, params, state));
+
+        std::filesystem::remove(path);
+    }
+
+    SECTION("Saving merges the attached snapshot in the background") {
+        auto first = snapshot_path("first");
+        auto second = snapshot_path("second");
+
+        FlatKeychain before(options);
+        auto old_key = before.generate_key(payload(1), params, state);
+        before.save_snapshot(first);
+
+        FlatKeychain after(options);
+        after.load_snapshot(first);
+        auto new_key = after.generate_key(payload(2), params, state);
+        after.save_snapshot_async(second).get();
+
+        FlatKeychain last(options);
+        last.load_snapshot(second);
+        REQUIRE(last.snapshot()->size() == 2);
+        REQUIRE(last.validate_key(old_key, params, state));
+        REQUIRE(last.validate_key(new_key, params, state));
+
+        std::filesystem::remove(first);
+        std::filesystem::remove(second);
+    }
+
+    SECTION("Revoked and evicted keys do not fall back to the snapshot") {
+        auto path = snapshot_path("revoked");
+        auto merged = snapshot_path("revoked_merged");
+
+        FlatKeychain before(options);
+        auto revoked = before.generate_key(payload(1), params, state);
+        auto evicted = before.generate_key(payload(2), params, state);
+        auto kept = before.generate_key(payload(3), params, state);
+        before.save_snapshot(path);
+
+        options.max_keys = 16;
+        FlatKeychain after(options);
+        after.load_snapshot(path);
+        REQUIRE(after.revoke_key(revoked));
+        REQUIRE_FALSE(after.revoke_key(revoked));
+        REQUIRE_FALSE(after.validate_key(revoked, params, state));
+        for (size_t i = 0; i < 200; ++i) {
+            after.generate_key(payload(100 + i), params, state);
+        }
+        REQUIRE(after.size() == 16);
+        REQUIRE_FALSE(after.validate_key(revoked, params, state));
+        REQUIRE(after.validate_key(kept, params, state));
+
+        FlatKeychain refreshed(options);
+        refreshed.load_snapshot(path);
+        REQUIRE(refreshed.validate_key(evicted, params, state));
+        // A regenerated key hides its snapshot copy; evicting it must not
+        // bring that copy back
+        REQUIRE(refreshed.generate_key(payload(2), params, state) == evicted);
+        for (size_t i = 0; i < 200; ++i) {
+            refreshed.generate_key(payload(100 + i), params, state);
+        }
+        REQUIRE_FALSE(refreshed.validate_key(evicted, params, state));
+
+        after.save_snapshot(merged);
+        FlatKeychain last(options);
+        last.load_snapshot(merged);
+        REQUIRE_FALSE(last.validate_key(revoked, params, state));
+        REQUIRE(last.validate_key(kept, params, state));
+
+        std::filesystem::remove(path);
+        std::filesystem::remove(merged);
+    }
+
+    SECTION("Expired keys are not restored") {
+        auto path = snapshot_path("expired");
+        options.ttl = std::chrono::hours(1);
+
+        FlatKeychain before(options);
+        auto key = before.generate_key(payload(1), params, state);
+        before.save_snapshot(path);
+
+        FlatKeychain after(options);
+        after.load_snapshot(path);
+        REQUIRE(after.validate_key(key, params, state));
+
+        // A record that expired after the file was written, with a context
+        // that would otherwise validate
+        Key stale_key{{}};
+        stale_key.get().fill(0xA5);
+        KeyRecord stale{};
+        stale.context = FlatKeychain::context_digest(params, state);
+        stale.expires_at = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            (now - std::chrono::seconds(1)).time_since_epoch()).count();
+        FlatKeyStore<KeyRecord> store(1);
+        store.insert(stale_key, stale);
+        KeySnapshot::write(path, store, options.version, options.nonce_mode);
+
+        FlatKeychain restored(options);
+        restored.load_snapshot(path);
+        REQUIRE(restored.snapshot()->size() == 1);
+        REQUIRE_FALSE(restored.validate_key(stale_key, params, state));
+
+        // Still honoured when expiry is off
+        KeychainOptions forever = options;
+        forever.ttl = std::chrono::seconds(0);
+        FlatKeychain unbounded(forever);
+        unbounded.load_snapshot(path);
+        REQUIRE(unbounded.validate_key(stale_key, params, state));
+
+        std::filesystem::remove(path);
+    }
+
+    SECTION("Invalid files are rejected") {
+        auto path = snapshot_path("invalid");
+        REQUIRE_THROWS_AS(FlatKeychain(options).load_snapshot(path), KeychainException);
+
+        {
+            std::ofstream out(path, std::ios::binary);
+            out << std::string(200, 'x');
+        }
+        REQUIRE_THROWS_AS(KeySnapshot(path), KeychainException);
+
+        FlatKeychain(options).save_snapshot(path);
+        {
+            std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+            file.seekp(24);
+            file.put('\x7F');
+        }
+        REQUIRE_THROWS_AS(KeySnapshot(path), KeychainException);
+
+        FlatKeychain(options).save_snapshot(path);
+        std::filesystem::resize_file(path, 100);
+        REQUIRE_THROWS_AS(KeySnapshot(path), KeychainException);
+
+        FlatKeychain(options).save_snapshot(path);
+        KeychainOptions other = options;
+        other.version = AlgorithmVersion::v1;
+        REQUIRE_THROWS_AS(FlatKeychain(other).load_snapshot(path), KeychainException);
+
+        std::filesystem::remove(path);
+    }
+}
@@ -30,6 +30,30 @@ TEST_CASE("Keychain management", "[keychain]") {
         REQUIRE(keychain.validate_key(key, params, state));
     }
 
+    SECTION("Generate and validate key with linear nonces") {
+        Keychain linear_keychain(AlgorithmVersion::v2, NonceMode::linear);
+        auto key = linear_keychain.generate_key(data, params, state);
+        REQUIRE(linear_keychain.validate_key(key, params, state));
+    }
+
+    SECTION("Non-throwing key generation") {
+        auto key = keychain.try_generate_key(data, params, state);
+        REQUIRE(key.has_value());
+        REQUIRE(*key == keychain.generate_key(data, params, state));
+        REQUIRE(keychain.validate_key(*key, params, state));
+
+        auto failed = keychain.try_generate_key({}, params, state);
+        REQUIRE(failed.error() == ErrorCode::empty_input);
+        REQUIRE(keychain.size() == 1);
+
+        FlatKeychain flat;
+        auto flat_key = flat.try_generate_key(data, params, state);
+        REQUIRE(flat_key.has_value());
+        REQUIRE(*flat_key == *key);
+        REQUIRE(flat.validate_key(*flat_key, params, state));
+        REQUIRE(flat.try_generate_key({}, params, state).error() == ErrorCode::empty_input);
+    }
+
     SECTION("Invalid key validation") {
         auto key = keychain.generate_key(data, params, state);
         
@@ -51,3 +75,424 @@ TEST_CASE("Keychain management", "[keychain]") {
         REQUIRE(key1.get() != key2.get());
     }
 }
+
+TEST_CASE("Keychain streaming key generation", "[keychain][stream]") {
+    Keychain keychain;
+    std::vector<uint8_t> data(10000, 0x5a);
+
+    SessionParams params{
+        "127.0.0.1",
+        "192.168.1.1",
+        std::chrono::system_clock::now(),
+        {}
+    };
+
+    SystemState state{
+        "content_hash",
+        50.0,
+        1024*1024,
+        std::chrono::system_clock::now(),
+        {}
+    };
+
+    SECTION("Streamed key validates") {
+        Keychain::KeyStream stream(params, state);
+        stream.update(std::span<const uint8_t>(data).first(4000));
+        stream.update(std::span<const uint8_t>(data).subspan(4000));
+
+        auto key = keychain.generate_key(stream);
+        REQUIRE(keychain.validate_key(key, params, state));
+    }
+
+    SECTION("Empty stream throws exception") {
+        Keychain::KeyStream stream(params, state);
+        REQUIRE_THROWS_AS(keychain.generate_key(stream), KeychainException);
+    }
+}
+
+TEST_CASE("Bounded keychain", "[keychain][bounded]") {
+    const auto now = std::chrono::system_clock::now();
+
+    SessionParams params{
+        "127.0.0.1",
+        "192.168.1.1",
+        now,
+        {}
+    };
+
+    SystemState state{
+        "content_hash",
+        50.0,
+        1024*1024,
+        now,
+        {}
+    };
+
+    auto payload = [](size_t i) {
+        std::vector<uint8_t> data(16, 0x33);
+        data[0] = static_cast<uint8_t>(i);
+        data[1] = static_cast<uint8_t>(i >> 8);
+        return data;
+    };
+
+    KeychainOptions options;
+    options.version = AlgorithmVersion::v2;
+    options.nonce_mode = NonceMode::linear;
+
+    SECTION("Key budget evicts") {
+        options.max_keys = 100;
+        Keychain keychain(options);
+        for (size_t i = 0; i < 1000; ++i) {
+            keychain.generate_key(payload(i), params, state);
+        }
+
+        auto stats = keychain.stats();
+        REQUIRE(stats.keys == 100);
+        REQUIRE(stats.evictions == 900);
+    }
+
+    SECTION("Recently validated keys get a second chance") {
+        options.max_keys = 10;
+        Keychain keychain(options);
+        std::vector<Key> keys;
+        for (size_t i = 0; i < 10; ++i) {
+            keys.push_back(keychain.generate_key(payload(i), params, state));
+        }
+
+        REQUIRE(keychain.validate_key(keys[0], params, state));
+        keychain.generate_key(payload(10), params, state);
+
+        REQUIRE(keychain.validate_key(keys[0], params, state));
+        REQUIRE_FALSE(keychain.validate_key(keys[1], params, state));
+        REQUIRE(keychain.stats().evictions == 1);
+    }
+
+    SECTION("Byte budget evicts") {
+        options.max_bytes = 64 * 1024;
+        Keychain keychain(options);
+        for (size_t i = 0; i < 5000; ++i) {
+            keychain.generate_key(payload(i), params, state);
+        }
+
+        auto stats = keychain.stats();
+        REQUIRE(stats.bytes <= options.max_bytes);
+        REQUIRE(stats.keys > 0);
+        REQUIRE(stats.evictions + stats.keys == 5000);
+    }
+
+    SECTION("Keys expire after their TTL") {
+        options.ttl = std::chrono::hours(1);
+        Keychain keychain(options);
+
+        auto live = keychain.generate_key(payload(1), params, state);
+        REQUIRE(keychain.validate_key(live, params, state));
+
+        SessionParams stale = params;
+        stale.timestamp = now - std::chrono::hours(2);
+        auto dead = keychain.generate_key(payload(2), stale, state);
+        REQUIRE_FALSE(keychain.validate_key(dead, stale, state));
+        REQUIRE(keychain.stats().expirations == 1);
+
+        keychain.expire(now + std::chrono::minutes(59));
+        REQUIRE(keychain.size() == 1);
+
+        keychain.expire(now + std::chrono::minutes(61));
+        REQUIRE(keychain.size() == 0);
+        REQUIRE(keychain.stats().expirations == 2);
+    }
+
+    SECTION("Moving leaves both keychains usable") {
+        options.max_keys = 10;
+        options.ttl = std::chrono::hours(1);
+        Keychain source(options);
+        std::vector<Key> keys;
+        for (size_t i = 0; i < 10; ++i) {
+            keys.push_back(source.generate_key(payload(i), params, state));
+        }
+
+        Keychain moved(std::move(source));
+        REQUIRE(moved.size() == 10);
+        REQUIRE(source.size() == 0);
+        REQUIRE(source.stats().bytes == 0);
+
+        // The moved-from keychain evicts and expires only its own keys
+        for (size_t i = 100; i < 120; ++i) {
+            source.generate_key(payload(i), params, state);
+        }
+        source.expire(now + std::chrono::minutes(61));
+        REQUIRE(source.size() == 0);
+
+        Keychain assigned(options);
+        assigned.generate_key(payload(200), params, state);
+        assigned = std::move(moved);
+        REQUIRE(assigned.size() == 10);
+        REQUIRE(moved.size() == 0);
+        moved.generate_key(payload(300), params, state);
+        REQUIRE(moved.size() == 1);
+
+        for (size_t i = 10; i < 15; ++i) {
+            assigned.generate_key(payload(i), params, state);
+        }
+        auto stats = assigned.stats();
+        REQUIRE(stats.keys == 10);
+        REQUIRE(stats.evictions == 5);
+        REQUIRE(assigned.validate_key(keys[9], params, state));
+        REQUIRE_FALSE(assigned.validate_key(keys[0], params, state));
+
+        assigned.expire(now + std::chrono::minutes(61));
+        REQUIRE(assigned.size() == 0);
+        REQUIRE(assigned.stats().expirations == 10);
+    }
+}
+
+TEST_CASE("Key filter", "[keychain][filter]") {
+    const auto now = std::chrono::system_clock::now();
+    SessionParams params{"127.0.0.1", "192.168.1.1", now, {}};
+    SystemState state{"content_hash", 50.0, 1024*1024, now, {}};
+
+    auto payload = [](size_t i) {
+        std::vector<uint8_t> data(16, 0x5a);
+        data[0] = static_cast<uint8_t>(i);
+        data[1] = static_cast<uint8_t>(i >> 8);
+        return data;
+    };
+    auto unknown = [](size_t i) {
+        std::array<uint8_t, 32> bytes;
+        for (size_t j = 0; j < bytes.size(); ++j) {
+            bytes[j] = static_cast<uint8_t>(detail::mix64(i * 32 + j));
+        }
+        return Key(bytes);
+    };
+
+    KeychainOptions options;
+    options.version = AlgorithmVersion::v2;
+    options.nonce_mode = NonceMode::linear;
+    options.filter_keys = 1000;
+
+    SECTION("Disabled by default") {
+        Keychain keychain;
+        REQUIRE(keychain.filter_stats().bytes == 0);
+    }
+
+    SECTION("Sized from the expected key count") {
+        Keychain keychain(options);
+        auto stats = keychain.filter_stats();
+        REQUIRE(stats.capacity == 2000);
+        REQUIRE(stats.bytes >= 2000 * options.filter_bits_per_key / 8);
+        REQUIRE(stats.false_positive_rate == 0);
+    }
+
+    SECTION("No false negatives across rebuilds") {
+        Keychain keychain(options);
+        std::vector<Key> keys;
+        for (size_t i = 0; i < 5000; ++i) {
+            keys.push_back(keychain.generate_key(payload(i), params, state));
+        }
+        auto stats = keychain.filter_stats();
+        REQUIRE(stats.rebuilds > 0);
+        REQUIRE(stats.capacity >= keychain.size());
+        for (const auto& key : keys) {
+            REQUIRE(keychain.validate_key(key, params, state));
+        }
+    }
+
+    SECTION("Unknown keys are rejected and the false-positive rate is measured") {
+        Keychain keychain(options);
+        for (size_t i = 0; i < 1000; ++i) {
+            keychain.generate_key(payload(i), params, state);
+        }
+
+        auto before = metrics::snapshot();
+        for (size_t i = 0; i < 20000; ++i) {
+            REQUIRE_FALSE(keychain.validate_key(unknown(i), params, state));
+        }
+        auto delta = metrics::snapshot() - before;
+        const auto& filter = delta[metrics::Op::key_filter];
+        REQUIRE(filter.calls == 20000);
+
+        const double measured = static_cast<double>(filter.failures) / static_cast<double>(filter.calls);
+        const double estimated = keychain.filter_stats().false_positive_rate;
+        REQUIRE(measured < 0.02);
+        REQUIRE(estimated > 0);
+        REQUIRE(estimated < 0.02);
+        REQUIRE(std::abs(measured - estimated) < 0.01);
+    }
+
+    SECTION("Evicted and expired keys stay rejected") {
+        options.max_keys = 1000;
+        options.ttl = std::chrono::hours(1);
+        Keychain keychain(options);
+        std::vector<Key> keys;
+        for (size_t i = 0; i < 4000; ++i) {
+            keys.push_back(keychain.generate_key(payload(i), params, state));
+        }
+        REQUIRE(keychain.stats().evictions == 3000);
+        REQUIRE(keychain.filter_stats().rebuilds > 0);
+        REQUIRE(keychain.filter_stats().capacity == 2000);
+        for (size_t i = 0; i < keys.size(); ++i) {
+            REQUIRE(keychain.validate_key(keys[i], params, state) == (i >= 3000));
+        }
+
+        keychain.expire(now + std::chrono::hours(2));
+        REQUIRE(keychain.size() == 0);
+        for (const auto& key : keys) {
+            REQUIRE_FALSE(keychain.validate_key(key, params, state));
+        }
+    }
+
+    SECTION("Concurrent keychain splits the filter between shards") {
+        ConcurrentKeychain keychain(options, 8);
+        std::vector<Key> keys;
+        for (size_t i = 0; i < 1000; ++i) {
+            keys.push_back(keychain.generate_key(payload(i), params, state));
+        }
+        auto stats = keychain.filter_stats();
+        REQUIRE(stats.capacity == 2000);
+        REQUIRE(stats.inserted == 1000);
+        REQUIRE(stats.false_positive_rate > 0);
+        for (const auto& key : keys) {
+            REQUIRE(keychain.validate_key(key, params, state));
+        }
+        REQUIRE_FALSE(keychain.validate_key(unknown(1), params, state));
+    }
+}
+
+TEST_CASE("Packed contexts and views", "[keychain][packed]") {
+    STATIC_REQUIRE(std::is_trivially_copyable_v<PackedSession>);
+    STATIC_REQUIRE(std::is_trivially_copyable_v<PackedState>);
+
+    const auto now = std::chrono::system_clock::now();
+    std::string input = "test data";
+    std::vector<uint8_t> data(input.begin(), input.end());
+
+    PackedSession session;
+    session.source_ip = IpAddress(std::array<uint8_t, 4>{127, 0, 0, 1});
+    session.dest_ip = IpAddress(std::array<uint8_t, 16>{0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1});
+    session.timestamp = now;
+
+    PackedState state;
+    state.content_hash.fill(0xAB);
+    state.cpu_load = 0.5;
+    state.memory_usage = 1 << 20;
+    state.timestamp = now;
+
+    // The same context spelled out with owning types
+    SessionParams params{
+        std::string("\x7f\x00\x00\x01", 4),
+        std::string(reinterpret_cast<const char*>(session.dest_ip.bytes.data()), 16),
+        now,
+        {}
+    };
+    SystemState system_state{
+        std::string(32, '\xAB'),
+        0.5,
+        1 << 20,
+        now,
+        {}
+    };
+
+    SECTION("Packed contexts hash like their owning equivalents") {
+        REQUIRE(HolographicHash::compute(data, session) == HolographicHash::compute(data, params));
+        REQUIRE(EmergentNonce::generate(data, state) == EmergentNonce::generate(data, system_state));
+
+        state.has_previous_nonce = true;
+        state.previous_nonce.fill(0x11);
+        system_state.previous_nonce.assign(16, 0x11);
+        REQUIRE(EmergentNonce::generate(data, state, AlgorithmVersion::v2, NonceMode::linear) ==
+                EmergentNonce::generate(data, system_state, AlgorithmVersion::v2, NonceMode::linear));
+    }
+
+    SECTION("Keys validate across context forms") {
+        Keychain keychain;
+        auto key = keychain.generate_key(data, session, state);
+        REQUIRE(keychain.validate_key(key, session, state));
+        REQUIRE(keychain.validate_key(key, params, system_state));
+
+        PackedSession other = session;
+        other.source_ip.bytes[3] = 2;
+        REQUIRE_FALSE(keychain.validate_key(key, other, state));
+
+        FlatKeychain flat;
+        REQUIRE(flat.generate_key(data, session, state) == key);
+        REQUIRE(flat.validate_key(key, params, system_state));
+        REQUIRE_FALSE(flat.validate_key(key, other, state));
+    }
+
+    SECTION("Context can be moved into the keychain") {
+        Keychain keychain;
+        SessionParams moved_params = params;
+        SystemState moved_state = system_state;
+        auto key = keychain.generate_key(data, std::move(moved_params), std::move(moved_state));
+        REQUIRE(keychain.validate_key(key, params, system_state));
+
+        Keychain::KeyStream stream{SessionParams(params), SystemState(system_state)};
+        stream.update(data);
+        REQUIRE(keychain.validate_key(keychain.generate_key(stream), params, system_state));
+    }
+}
+
+TEST_CASE("Batch key generation", "[keychain][batch]") {
+    const auto now = std::chrono::system_clock::now();
+
+    std::vector<std::vector<uint8_t>> messages;
+    std::vector<SessionParams> params;
+    std::vector<SystemState> states;
+    for (size_t i = 0; i < 1000; ++i) {
+        messages.emplace_back(20 + i % 50, static_cast<uint8_t>(i));
+        messages.back()[1] = static_cast<uint8_t>(i >> 8);
+        params.push_back(SessionParams{"127.0.0.1", "192.168.1.1", now + std::chrono::seconds(i % 7), {}});
+        states.push_back(SystemState{"content_hash", 50.0, 1024 * 1024 + i, now, {}});
+    }
+    std::vector<std::span<const uint8_t>> inputs(messages.begin(), messages.end());
+
+    ThreadPool pool(3);
+
+    for (auto version : {AlgorithmVersion::v1, AlgorithmVersion::v2}) {
+        KeychainOptions options;
+        options.version = version;
+        options.nonce_mode = NonceMode::linear;
+
+        Keychain batch(options);
+        auto keys = batch.generate_keys(inputs, params, states, &pool);
+        REQUIRE(keys.size() == inputs.size());
+        REQUIRE(batch.size() == inputs.size());
+
+        // Same keys, in input order, as one generate_key() per triple
+        Keychain single(options);
+        size_t mismatches = 0;
+        for (size_t i = 0; i < inputs.size(); ++i) {
+            mismatches += keys[i] != single.generate_key(inputs[i], params[i], states[i]);
+            mismatches += !batch.validate_key(keys[i], params[i], states[i]);
+        }
+        REQUIRE(mismatches == 0);
+    }
+
+    SECTION("Views and the shared pool") {
+        std::vector<SessionView> param_views(params.begin(), params.end());
+        std::vector<StateView> state_views(states.begin(), states.end());
+
+        Keychain keychain;
+        auto keys = keychain.generate_keys(inputs, param_views, state_views);
+        REQUIRE(keys.front() == Keychain().generate_key(inputs.front(), params.front(), states.front()));
+        REQUIRE(keychain.validate_key(keys.back(), params.back(), states.back()));
+    }
+
+    SECTION("Budgets still apply") {
+        KeychainOptions options;
+        options.max_keys = 100;
+        Keychain keychain(options);
+        keychain.generate_keys(inputs, params, states, &pool);
+        REQUIRE(keychain.size() == 100);
+        REQUIRE(keychain.stats().evictions == 900);
+    }
+
+    SECTION("Failed batches insert nothing") {
+        Keychain keychain;
+        REQUIRE_THROWS_AS(keychain.generate_keys(inputs, std::span<const SessionParams>(params).first(10),
+                                                 states, &pool), InvalidInputException);
+
+        inputs[500] = {};
+        REQUIRE_THROWS_AS(keychain.generate_keys(inputs, params, states, &pool), InvalidInputException);
+        REQUIRE(keychain.size() == 0);
+    }
+}
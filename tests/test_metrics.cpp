@@ -0,0 +1,105 @@
+#include <catch2/catch.hpp>
+#include <holohash/core.hpp>
+#include <thread>
+#include <vector>
+
+using namespace holohash;
+
+TEST_CASE("Metrics", "[metrics]") {
+    SECTION("Log-linear buckets stay within 1/16 of their values") {
+        for (uint64_t value : {uint64_t{0}, uint64_t{15}, uint64_t{16}, uint64_t{17}, uint64_t{1000},
+                               uint64_t{123456789}, uint64_t{1} << 40, UINT64_MAX}) {
+            const size_t i = metrics::Buckets::index(value);
+            REQUIRE(metrics::Buckets::lower(i) <= value);
+            REQUIRE(metrics::Buckets::upper(i) >= value);
+            REQUIRE(metrics::Buckets::upper(i) - metrics::Buckets::lower(i) <= std::max<uint64_t>(value / 16, 1));
+        }
+
+        metrics::Histogram histogram;
+        for (uint64_t ns = 1; ns <= 1000; ++ns) {
+            histogram.record(ns);
+        }
+        REQUIRE(histogram.count() == 1000);
+        REQUIRE(histogram.max() == 1000);
+        REQUIRE(histogram.percentile(50) == Approx(500).epsilon(1.0 / 16));
+        REQUIRE(histogram.percentile(99) == Approx(990).epsilon(1.0 / 16));
+        REQUIRE(histogram.mean() == Approx(500.5).epsilon(1.0 / 16));
+    }
+
+    if (!metrics::enabled) {
+        return;
+    }
+
+    SessionParams params{"127.0.0.1", "192.168.1.1", std::chrono::system_clock::now(), {}};
+    SystemState state{"content_hash", 50.0, 1024 * 1024, std::chrono::system_clock::now(), {}};
+    std::vector<uint8_t> data(100, 0x5A);
+
+    SECTION("Hot-path operations are counted and timed") {
+        const auto before = metrics::snapshot();
+
+        Keychain keychain(AlgorithmVersion::v2, NonceMode::linear);
+        auto key = keychain.generate_key(data, params, state);
+        REQUIRE(keychain.validate_key(key, params, state));
+        REQUIRE_FALSE(keychain.validate_key(Key{{}}, params, state));
+
+        std::vector<std::span<const uint8_t>> inputs(20, data);
+        std::vector<SessionParams> batch(20, params);
+        std::vector<Hash> out(20, Hash{{}});
+        HolographicHash::compute_batch(inputs, batch, out);
+
+        const auto delta = metrics::snapshot() - before;
+        REQUIRE(delta[metrics::Op::generate_key].calls == 1);
+        REQUIRE(delta[metrics::Op::generate_key].bytes == 100);
+        REQUIRE(delta[metrics::Op::validate_key].calls == 2);
+        REQUIRE(delta[metrics::Op::validate_key].failures == 1);
+        REQUIRE(delta[metrics::Op::validate_key].latency.count() == 2);
+        REQUIRE(delta[metrics::Op::nonce].calls == 1);
+
+        // One timed compute from generate_key, twenty counted in the batch
+        REQUIRE(delta[metrics::Op::hash].calls == 21);
+        REQUIRE(delta[metrics::Op::hash].bytes == 2100);
+        REQUIRE(delta[metrics::Op::hash].latency.count() == 1);
+        REQUIRE(delta[metrics::Op::hash].latency.percentile(50) > 0);
+    }
+
+    SECTION("Counts from other threads survive the threads") {
+        const auto before = metrics::snapshot();
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; ++t) {
+            threads.emplace_back([&] {
+                for (int i = 0; i < 100; ++i) {
+                    HolographicHash::compute(data, params);
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        const auto delta = metrics::snapshot() - before;
+        REQUIRE(delta[metrics::Op::hash].calls == 400);
+        REQUIRE(delta[metrics::Op::hash].latency.count() == 400);
+    }
+
+    SECTION("Keychain table shape") {
+        Keychain keychain(AlgorithmVersion::v2, NonceMode::linear);
+        for (int i = 0; i < 500; ++i) {
+            data[0] = static_cast<uint8_t>(i);
+            data[1] = static_cast<uint8_t>(i >> 8);
+            keychain.generate_key(data, params, state);
+        }
+        auto table = keychain.table_stats();
+        REQUIRE(table.keys == 500);
+        REQUIRE(table.buckets >= 500);
+        REQUIRE(table.load_factor == Approx(500.0 / table.buckets));
+        REQUIRE(table.longest_chain >= 1);
+        REQUIRE(table.empty_buckets < table.buckets);
+
+        ConcurrentKeychain concurrent(8, AlgorithmVersion::v2, NonceMode::linear);
+        for (int i = 0; i < 500; ++i) {
+            data[0] = static_cast<uint8_t>(i);
+            data[1] = static_cast<uint8_t>(i >> 8);
+            concurrent.generate_key(data, params, state);
+        }
+        REQUIRE(concurrent.table_stats().keys == 500);
+    }
+}
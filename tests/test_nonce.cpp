@@ -40,4 +40,252 @@ TEST_CASE("EmergentNonce generation", "[nonce]") {
 
         REQUIRE(nonce1.get() != nonce2.get());
     }
+
+    SECTION("Non-throwing variant") {
+        std::vector<uint8_t> data(input.begin(), input.end());
+        for (auto version : {AlgorithmVersion::v1, AlgorithmVersion::v2}) {
+            for (auto mode : {NonceMode::recursive, NonceMode::linear}) {
+                auto nonce = EmergentNonce::try_generate(data, state, version, mode);
+                REQUIRE(nonce.has_value());
+                REQUIRE(*nonce == EmergentNonce::generate(data, state, version, mode));
+            }
+        }
+
+        auto failed = EmergentNonce::try_generate({}, state);
+        REQUIRE_FALSE(failed.has_value());
+        REQUIRE(failed.error() == ErrorCode::empty_input);
+        static_assert(noexcept(EmergentNonce::try_generate({}, state)));
+    }
+}
+
+TEST_CASE("NonceStream incremental generation", "[nonce][stream]") {
+    SystemState state{
+        "content_hash",
+        50.0,
+        1024*1024,
+        std::chrono::system_clock::now(),
+        {}
+    };
+
+    std::vector<uint8_t> data(1000);
+    for (size_t i = 0; i < data.size(); ++i) {
+        data[i] = static_cast<uint8_t>(i * 13 + 5);
+    }
+
+    SECTION("Nonce does not depend on chunking") {
+        NonceStream whole(state);
+        whole.update(data);
+
+        NonceStream pieces(state);
+        for (size_t off = 0; off < data.size(); off += 7) {
+            pieces.update(std::span<const uint8_t>(data).subspan(off, std::min<size_t>(7, data.size() - off)));
+        }
+
+        REQUIRE(pieces.finalize().get() == whole.finalize().get());
+    }
+
+    SECTION("Stream matches one-shot linear mode") {
+        NonceStream stream(state);
+        stream.update(data);
+        REQUIRE(stream.finalize().get() ==
+                EmergentNonce::generate(data, state, AlgorithmVersion::v1, NonceMode::linear).get());
+    }
+
+    SECTION("Different states produce different nonces") {
+        SystemState other = state;
+        other.memory_usage += 1;
+
+        NonceStream a(state);
+        NonceStream b(other);
+        a.update(data);
+        b.update(data);
+
+        REQUIRE(a.finalize().get() != b.finalize().get());
+    }
+
+    SECTION("Empty stream throws exception") {
+        NonceStream stream(state);
+        REQUIRE_THROWS_AS(stream.finalize(), NonceGenerationException);
+    }
+}
+
+TEST_CASE("EmergentNonce v2 output specification", "[nonce][v2]") {
+    std::string input = "holographic";
+    std::vector<uint8_t> data(input.begin(), input.end());
+    SystemState state{
+        "content_hash",
+        0.5,
+        4096,
+        std::chrono::system_clock::time_point{std::chrono::seconds{1700000000}},
+        {}
+    };
+
+    const std::array<uint8_t, 16> expected = {
+        0x80, 0x74, 0xdd, 0x2f, 0x06, 0xc5, 0x27, 0x64,
+        0x1d, 0x53, 0xb3, 0x43, 0x63, 0x13, 0x3b, 0x2b
+    };
+    REQUIRE(EmergentNonce::generate(data, state, AlgorithmVersion::v2).get() == expected);
+}
+
+TEST_CASE("EmergentNonce linear mode", "[nonce][linear]") {
+    SystemState state{
+        "content_hash",
+        50.0,
+        1024*1024,
+        std::chrono::system_clock::now(),
+        {}
+    };
+
+    auto linear = [&](const std::vector<uint8_t>& data, const SystemState& s) {
+        return EmergentNonce::generate(data, s, AlgorithmVersion::v2, NonceMode::linear).get();
+    };
+
+    SECTION("Every input byte and the length matter") {
+        std::vector<uint8_t> data(100, 0x11);
+        auto base = linear(data, state);
+        for (size_t i = 0; i < data.size(); ++i) {
+            auto changed = data;
+            changed[i] ^= 0x80;
+            REQUIRE(linear(changed, state) != base);
+        }
+
+        auto longer = data;
+        longer.push_back(0);
+        REQUIRE(linear(longer, state) != base);
+    }
+
+    SECTION("Tails that differ only in padding do not collide") {
+        // Tails of 9-15 bytes reach the half of the last block that once
+        // carried the length
+        std::vector<uint8_t> short_tail = {1, 2, 3, 4, 5, 6, 7, 8, 0x41};
+        std::vector<uint8_t> long_tail = {1, 2, 3, 4, 5, 6, 7, 8, 0x41 ^ 9 ^ 10, 0x00};
+        REQUIRE(linear(short_tail, state) != linear(long_tail, state));
+
+        for (size_t prefix : {size_t{0}, size_t{32}}) {
+            for (size_t tail = 9; tail < 16; ++tail) {
+                std::vector<uint8_t> data(prefix + tail, 0x33);
+                auto padded = data;
+                padded.push_back(0);
+                INFO("prefix " << prefix << ", tail " << tail);
+                REQUIRE(linear(padded, state) != linear(data, state));
+
+                // Absorbing the length into the data half would need this
+                // byte to cancel the length change
+                auto cancelled = padded;
+                cancelled[prefix + 8] ^= static_cast<uint8_t>(data.size() ^ padded.size());
+                REQUIRE(linear(cancelled, state) != linear(data, state));
+            }
+        }
+    }
+
+    SECTION("Previous nonce is chained in") {
+        std::vector<uint8_t> data(40, 0x22);
+        SystemState chained = state;
+        chained.previous_nonce = {1, 2, 3};
+        REQUIRE(linear(data, chained) != linear(data, state));
+    }
+
+    SECTION("Empty input throws exception") {
+        std::vector<uint8_t> empty_data;
+        REQUIRE_THROWS_AS(
+            EmergentNonce::generate(empty_data, state, AlgorithmVersion::v2, NonceMode::linear),
+            NonceGenerationException
+        );
+    }
+}
+
+TEST_CASE("NonceChain", "[nonce][chain]") {
+    SystemState state{
+        "content_hash",
+        50.0,
+        1024*1024,
+        std::chrono::system_clock::time_point{std::chrono::seconds{1700000000}},
+        {}
+    };
+
+    auto link_input = [](uint64_t i) {
+        std::vector<uint8_t> data(24, 0x4E);
+        data[0] = static_cast<uint8_t>(i);
+        data[1] = static_cast<uint8_t>(i >> 8);
+        return data;
+    };
+
+    SECTION("Links match generate with the previous nonce") {
+        for (auto mode : {NonceMode::recursive, NonceMode::linear}) {
+            for (auto version : {AlgorithmVersion::v1, AlgorithmVersion::v2}) {
+                NonceChain chain(version, mode);
+                SystemState chained = state;
+                for (uint64_t i = 0; i < 10; ++i) {
+                    auto expected = EmergentNonce::generate(link_input(i), chained, version, mode);
+                    REQUIRE(chain.next(link_input(i), state) == expected);
+                    chained.previous_nonce.assign(expected.get().begin(), expected.get().end());
+                }
+                REQUIRE(chain.position() == 10);
+            }
+        }
+    }
+
+    SECTION("Seeded chains start from the seed") {
+        Nonce seed{{1, 2, 3, 4}};
+        NonceChain chain(seed, AlgorithmVersion::v2, NonceMode::linear);
+        REQUIRE(chain.head() == seed);
+
+        SystemState chained = state;
+        chained.previous_nonce.assign(seed.get().begin(), seed.get().end());
+        REQUIRE(chain.next(link_input(0), state) ==
+                EmergentNonce::generate(link_input(0), chained, AlgorithmVersion::v2, NonceMode::linear));
+    }
+
+    SECTION("Rollback within the history") {
+        NonceChain chain(AlgorithmVersion::v2, NonceMode::linear);
+        std::vector<Nonce> links;
+        for (uint64_t i = 0; i < 200; ++i) {
+            links.push_back(chain.next(link_input(i), state));
+        }
+
+        chain.rollback(10);
+        REQUIRE(chain.position() == 190);
+        REQUIRE(chain.head() == links[189]);
+
+        // Advancing again from the earlier link reproduces the chain
+        REQUIRE(chain.next(link_input(190), state) == links[190]);
+
+        REQUIRE(chain.can_rewind(200 - NonceChain::history + 1));
+        REQUIRE_FALSE(chain.can_rewind(200 - NonceChain::history));
+        REQUIRE_THROWS_AS(chain.rewind(100), NonceGenerationException);
+        REQUIRE_THROWS_AS(chain.rewind(192), NonceGenerationException);
+        REQUIRE_THROWS_AS(chain.rollback(500), NonceGenerationException);
+
+        chain.rewind(0);
+        REQUIRE(chain.head() == Nonce{{}});
+        REQUIRE(chain.next(link_input(0), state) == links[0]);
+    }
+
+    SECTION("Checkpoints restore branches") {
+        NonceChain chain(AlgorithmVersion::v2, NonceMode::linear);
+        for (uint64_t i = 0; i < 5; ++i) {
+            chain.next(link_input(i), state);
+        }
+        const auto fork = chain.checkpoint();
+
+        chain.next(link_input(100), state);
+        const auto branch_a = chain.checkpoint();
+
+        chain.restore(fork);
+        REQUIRE(chain.checkpoint() == fork);
+        chain.next(link_input(200), state);
+        REQUIRE(chain.head().get() != branch_a.head);
+
+        // Branch A's link was overwritten, so it is restored from its head
+        chain.restore(branch_a);
+        REQUIRE(chain.checkpoint() == branch_a);
+        REQUIRE_FALSE(chain.can_rewind(branch_a.position - 1));
+
+        // Checkpoints far older than the ring still restore
+        for (uint64_t i = 0; i < 3 * NonceChain::history; ++i) {
+            chain.next(link_input(i), state);
+        }
+        chain.restore(fork);
+        REQUIRE(chain.checkpoint() == fork);
+    }
 }
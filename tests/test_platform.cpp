@@ -1,6 +1,7 @@
 #include <catch2/catch.hpp>
 #include <holohash/platform.hpp>
 #include <vector>
+#include <random>
 
 using namespace holohash::platform;
 
@@ -26,3 +27,97 @@ TEST_CASE("Alignment check functionality", "[platform]") {
     double d = 0.0;
     REQUIRE(is_aligned(&d, sizeof(double)));
 }
+
+TEST_CASE("Kernel dispatch levels agree with scalar reference", "[platform][dispatch]") {
+    std::mt19937 gen(42);
+    auto random_bytes = [&](size_t n) {
+        std::vector<uint8_t> v(n);
+        for (auto& b : v) {
+            b = static_cast<uint8_t>(gen());
+        }
+        return v;
+    };
+
+    const auto original = active_simd_level();
+    const auto& reference = kernel_table(SimdLevel::scalar);
+
+    for (auto level : {SimdLevel::sse2, SimdLevel::avx2, SimdLevel::avx512}) {
+        if (level > detect_simd_level()) {
+            continue;
+        }
+        const auto& table = kernel_table(level);
+        REQUIRE(table.level == level);
+
+        for (size_t len : {size_t{0}, size_t{7}, size_t{16}, size_t{33}, size_t{100}, size_t{257}}) {
+            auto src = random_bytes(len);
+            auto expected = random_bytes(len);
+            auto actual = expected;
+            reference.xor_block(expected.data(), src.data(), len);
+            table.xor_block(actual.data(), src.data(), len);
+            REQUIRE(actual == expected);
+        }
+
+        for (int trial = 0; trial < 100; ++trial) {
+            auto iv = random_bytes(16);
+            auto expected = random_bytes(32);
+            auto actual = expected;
+
+            reference.rotate_add(expected.data(), iv.data());
+            table.rotate_add(actual.data(), iv.data());
+            REQUIRE(actual == expected);
+
+            reference.mix_round(expected.data());
+            table.mix_round(actual.data());
+            REQUIRE(actual == expected);
+
+            auto gathered = random_bytes(8 * 32);
+            reference.transform(expected.data(), iv.data(), gathered.data(), 8, 4);
+            table.transform(actual.data(), iv.data(), gathered.data(), 8, 4);
+            REQUIRE(actual == expected);
+        }
+    }
+
+    REQUIRE(set_simd_level(SimdLevel::scalar) == SimdLevel::scalar);
+    REQUIRE(active_simd_level() == SimdLevel::scalar);
+    REQUIRE(set_simd_level(SimdLevel::avx512) == detect_simd_level());
+    set_simd_level(original);
+}
+
+TEST_CASE("Unrolled fixed-width kernel agrees with scalar reference", "[platform][fixed]") {
+    std::mt19937 gen(7);
+    auto fill = [&](auto& bytes) {
+        for (auto& b : bytes) {
+            b = static_cast<uint8_t>(gen());
+        }
+    };
+
+    for (int trial = 0; trial < 100; ++trial) {
+        std::array<uint8_t, 32> expected;
+        std::array<uint8_t, 16> iv;
+        std::array<uint8_t, 8 * 32> gathered;
+        fill(expected);
+        fill(iv);
+        fill(gathered);
+        auto actual = expected;
+
+        kernels::scalar::transform(expected.data(), iv.data(), gathered.data(), 8, 4);
+        kernels::fixed::transform<32, 8, 4>(actual, iv, gathered);
+        REQUIRE(actual == expected);
+
+        kernels::scalar::mix_round(expected.data());
+        kernels::fixed::mix_round(actual);
+        REQUIRE(actual == expected);
+    }
+}
+
+TEST_CASE("SIMD level names round-trip", "[platform][dispatch]") {
+    for (auto level : {SimdLevel::scalar, SimdLevel::sse2, SimdLevel::avx2, SimdLevel::avx512}) {
+        SimdLevel parsed = SimdLevel::scalar;
+        REQUIRE(parse_simd_level(simd_level_name(level), parsed));
+        REQUIRE(parsed == level);
+    }
+
+    SimdLevel parsed = SimdLevel::sse2;
+    REQUIRE_FALSE(parse_simd_level("neon", parsed));
+    REQUIRE(parsed == SimdLevel::sse2);
+}
@@ -0,0 +1,97 @@
+#include <catch2/catch.hpp>
+#include <holohash/thread_pool.hpp>
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace holohash;
+
+TEST_CASE("Thread pool", "[thread_pool]") {
+    ThreadPool pool(3);
+    REQUIRE(pool.concurrency() == 4);
+
+    SECTION("Every index runs exactly once") {
+        std::vector<std::atomic<int>> hits(10000);
+        pool.parallel_for(hits.size(), [&](size_t i) {
+            hits[i].fetch_add(1, std::memory_order_relaxed);
+        });
+
+        size_t wrong = 0;
+        for (const auto& hit : hits) {
+            wrong += hit.load() != 1;
+        }
+        REQUIRE(wrong == 0);
+
+        pool.parallel_for(0, [](size_t) { FAIL("no indices"); });
+    }
+
+    SECTION("Work is spread over threads") {
+        std::mutex mutex;
+        std::vector<std::thread::id> ids;
+        pool.parallel_for(64, [&](size_t) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            std::lock_guard lock(mutex);
+            if (std::find(ids.begin(), ids.end(), std::this_thread::get_id()) == ids.end()) {
+                ids.push_back(std::this_thread::get_id());
+            }
+        });
+        REQUIRE(ids.size() > 1);
+    }
+
+    SECTION("Idle threads steal from a slow one") {
+        std::vector<std::thread::id> ran_on(100);
+        pool.parallel_for(ran_on.size(), [&](size_t i) {
+            if (i == 0) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(200));
+            }
+            ran_on[i] = std::this_thread::get_id();
+        });
+
+        // Indices 1..24 belong to the same range as index 0
+        size_t stolen = 0;
+        for (size_t i = 1; i < 25; ++i) {
+            stolen += ran_on[i] != ran_on[0];
+        }
+        REQUIRE(stolen > 0);
+    }
+
+    SECTION("Nested and concurrent loops complete") {
+        std::atomic<size_t> total{0};
+        std::vector<std::thread> callers;
+        for (int t = 0; t < 4; ++t) {
+            callers.emplace_back([&] {
+                pool.parallel_for(8, [&](size_t) {
+                    pool.parallel_for(8, [&](size_t) { total.fetch_add(1); });
+                });
+            });
+        }
+        for (auto& caller : callers) {
+            caller.join();
+        }
+        REQUIRE(total.load() == 4 * 8 * 8);
+    }
+
+    SECTION("A pool without workers runs on the caller") {
+        ThreadPool inline_pool(0);
+        REQUIRE(inline_pool.concurrency() == 1);
+
+        const auto caller = std::this_thread::get_id();
+        size_t elsewhere = 0;
+        inline_pool.parallel_for(100, [&](size_t) { elsewhere += std::this_thread::get_id() != caller; });
+        REQUIRE(elsewhere == 0);
+    }
+
+    SECTION("Exceptions reach the caller") {
+        REQUIRE_THROWS_AS(pool.parallel_for(100, [](size_t i) {
+            if (i == 42) {
+                throw std::runtime_error("leaf failed");
+            }
+        }), std::runtime_error);
+
+        // The pool is still usable afterwards
+        std::atomic<size_t> count{0};
+        pool.parallel_for(10, [&](size_t) { count.fetch_add(1); });
+        REQUIRE(count.load() == 10);
+    }
+}
@@ -0,0 +1,77 @@
+#include <catch2/catch.hpp>
+#include <holohash/timer_wheel.hpp>
+#include <vector>
+#include <random>
+
+using namespace holohash;
+
+namespace {
+
+struct Item {
+    TimerHook<Item> hook;
+    uint64_t deadline = 0;
+    uint64_t fired_at = 0;
+    bool fired = false;
+};
+
+struct HookOf {
+    TimerHook<Item>& operator()(Item* item) const noexcept { return item->hook; }
+};
+
+using Wheel = TimerWheel<Item, HookOf>;
+
+} // namespace
+
+TEST_CASE("TimerWheel expiry", "[timer_wheel]") {
+    Wheel wheel(1000);
+    std::mt19937_64 gen(7);
+
+    std::vector<Item> items(2000);
+    for (size_t i = 0; i < items.size(); ++i) {
+        // Spread deadlines over every level, including beyond the horizon
+        uint64_t span = uint64_t{1} << (4 + (i % 6) * 4);
+        items[i].deadline = 1000 + gen() % span;
+        wheel.schedule(&items[i], items[i].deadline);
+    }
+    REQUIRE(wheel.size() == items.size());
+
+    auto on_expire = [&](Item* item) {
+        item->fired = true;
+        item->fired_at = wheel.now();
+    };
+
+    SECTION("Items fire exactly at their deadline") {
+        uint64_t now = 1000;
+        while (wheel.size() > 0) {
+            now += 1 + gen() % 5000;
+            wheel.advance(now, on_expire);
+
+            size_t mismatched = 0;
+            for (const auto& item : items) {
+                mismatched += item.fired != (item.deadline <= now);
+            }
+            REQUIRE(mismatched == 0);
+        }
+        for (const auto& item : items) {
+            REQUIRE(item.fired_at >= item.deadline);
+        }
+    }
+
+    SECTION("Large jumps fire everything due") {
+        wheel.advance(uint64_t{1} << 30, on_expire);
+        REQUIRE(wheel.size() == 0);
+        for (const auto& item : items) {
+            REQUIRE(item.fired);
+        }
+    }
+
+    SECTION("Cancelled items never fire") {
+        for (size_t i = 0; i < items.size(); i += 2) {
+            wheel.cancel(&items[i]);
+        }
+        wheel.advance(uint64_t{1} << 30, on_expire);
+        for (size_t i = 0; i < items.size(); ++i) {
+            REQUIRE(items[i].fired == (i % 2 == 1));
+        }
+    }
+}
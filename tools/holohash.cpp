@@ -0,0 +1,304 @@
+#include <holohash/core.hpp>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace holohash;
+
+namespace {
+
+enum class Mode {
+    stream,
+    tree,
+    compute
+};
+
+struct Options {
+    std::vector<std::string> paths;
+    SessionParams params{"", "", std::chrono::system_clock::time_point{}, {}};
+    Mode mode = Mode::stream;
+    AlgorithmVersion version = AlgorithmVersion::v2;
+    size_t chunk_size = size_t{1} << 20;
+    size_t threads = 0;
+    bool json = false;
+    bool summary = true;
+};
+
+struct FileResult {
+    std::string path;
+    uint64_t size = 0;
+    Hash hash{{}};
+    std::string error;
+    bool skipped = false;
+};
+
+void usage(std::ostream& out) {
+    out << "Usage: holohash [options] <file|directory>...\n"
+           "\n"
+           "Hashes files, and every regular file below each directory.\n"
+           "\n"
+           "Options:\n"
+           "  --source-ip <ip>        session source address (default empty)\n"
+           "  --dest-ip <ip>          session destination address (default empty)\n"
+           "  --timestamp <seconds>   session time since the epoch (default 0)\n"
+           "  --mode stream|tree|compute\n"
+           "                          digest kind (default stream, as HashStream)\n"
+           "  --version v1|v2         algorithm version for compute mode (default v2)\n"
+           "  --chunk-size <bytes>    leaf size for tree mode (default 1048576)\n"
+           "  --threads <n>           worker threads (default: all cores)\n"
+           "  --format hex|json       one line per file (default hex)\n"
+           "  --no-summary            do not print the summary to stderr\n"
+           "  --help                  show this help\n";
+}
+
+[[noreturn]] void fail(const std::string& message) {
+    std::cerr << "holohash: " << message << "\n";
+    usage(std::cerr);
+    std::exit(2);
+}
+
+Options parse(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto value = [&]() -> std::string {
+            if (i + 1 >= argc) {
+                fail("missing value for " + arg);
+            }
+            return argv[++i];
+        };
+        auto number = [&]() -> uint64_t {
+            std::string text = value();
+            try {
+                size_t used = 0;
+                uint64_t n = std::stoull(text, &used);
+                if (used == text.size()) {
+                    return n;
+                }
+            } catch (const std::exception&) {
+            }
+            fail("invalid number for " + arg + ": " + text);
+        };
+
+        if (arg == "--help" || arg == "-h") {
+            usage(std::cout);
+            std::exit(0);
+        } else if (arg == "--source-ip") {
+            options.params.source_ip = value();
+        } else if (arg == "--dest-ip") {
+            options.params.dest_ip = value();
+        } else if (arg == "--timestamp") {
+            options.params.timestamp = std::chrono::system_clock::time_point{
+                std::chrono::seconds{static_cast<int64_t>(number())}};
+        } else if (arg == "--mode") {
+            std::string mode = value();
+            if (mode == "stream") {
+                options.mode = Mode::stream;
+            } else if (mode == "tree") {
+                options.mode = Mode::tree;
+            } else if (mode == "compute") {
+                options.mode = Mode::compute;
+            } else {
+                fail("unknown mode " + mode);
+            }
+        } else if (arg == "--version") {
+            std::string version = value();
+            if (version == "v1") {
+                options.version = AlgorithmVersion::v1;
+            } else if (version == "v2") {
+                options.version = AlgorithmVersion::v2;
+            } else {
+                fail("unknown version " + version);
+            }
+        } else if (arg == "--chunk-size") {
+            options.chunk_size = number();
+        } else if (arg == "--threads") {
+            options.threads = number();
+        } else if (arg == "--format") {
+            std::string format = value();
+            if (format != "hex" && format != "json") {
+                fail("unknown format " + format);
+            }
+            options.json = format == "json";
+        } else if (arg == "--no-summary") {
+            options.summary = false;
+        } else if (arg.size() > 1 && arg[0] == '-') {
+            fail("unknown option " + arg);
+        } else {
+            options.paths.push_back(arg);
+        }
+    }
+    if (options.paths.empty()) {
+        fail("no input files");
+    }
+    return options;
+}
+
+std::string hex(const Hash& hash) {
+    static constexpr char digits[] = "0123456789abcdef";
+    std::string out;
+    out.reserve(hash.get().size() * 2);
+    for (uint8_t byte : hash.get()) {
+        out += digits[byte >> 4];
+        out += digits[byte & 0xF];
+    }
+    return out;
+}
+
+std::string json_string(const std::string& text) {
+    std::ostringstream out;
+    out << '"';
+    for (unsigned char c : text) {
+        switch (c) {
+            case '"': out << "\\\""; break;
+            case '\\': out << "\\\\"; break;
+            case '\n': out << "\\n"; break;
+            case '\r': out << "\\r"; break;
+            case '\t': out << "\\t"; break;
+            default:
+                if (c < 0x20) {
+                    out << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c) << std::dec;
+                } else {
+                    out << c;
+                }
+        }
+    }
+    out << '"';
+    return out.str();
+}
+
+// Maps the file and hashes it in place; the sequential hint lets the
+// kernel read ahead of the hash. Results that already failed, such as an
+// unreadable directory, are passed through as they are.
+void hash_file(const Options& options, ThreadPool& pool, FileResult& result) {
+    if (!result.error.empty()) {
+        return;
+    }
+    platform::MappedFile file;
+    if (!file.open(result.path.c_str(), platform::MappedFile::Access::sequential)) {
+        result.error = "cannot open or map file";
+        return;
+    }
+    result.size = file.size();
+    if (file.size() == 0) {
+        result.skipped = true;
+        result.error = "empty file";
+        return;
+    }
+
+    std::span<const uint8_t> data(file.data(), file.size());
+    try {
+        switch (options.mode) {
+            case Mode::stream: {
+                HashStream stream(options.params);
+                stream.update(data);
+                result.hash = stream.finalize();
+                break;
+            }
+            case Mode::tree: {
+                TreeParams tree;
+                tree.chunk_size = options.chunk_size;
+                tree.pool = &pool;
+                result.hash = HolographicHash::compute_tree(data, options.params, tree);
+                break;
+            }
+            case Mode::compute:
+                result.hash = HolographicHash::compute(data, options.params, options.version);
+                break;
+        }
+    } catch (const HoloHashException& e) {
+        result.error = e.what();
+    }
+}
+
+void print(const Options& options, const FileResult& result) {
+    if (options.json) {
+        std::cout << "{\"path\":" << json_string(result.path) << ",\"size\":" << result.size;
+        if (result.error.empty()) {
+            std::cout << ",\"hash\":\"" << hex(result.hash) << "\"}\n";
+        } else {
+            std::cout << ",\"error\":" << json_string(result.error) << "}\n";
+        }
+    } else if (result.error.empty()) {
+        std::cout << hex(result.hash) << "  " << result.path << "\n";
+    } else {
+        std::cerr << "holohash: " << result.path << ": " << result.error << "\n";
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const Options options = parse(argc, argv);
+    if (options.mode == Mode::tree &&
+        (options.chunk_size == 0 || options.chunk_size % HashStream::block_size != 0)) {
+        fail("--chunk-size must be a positive multiple of " + std::to_string(HashStream::block_size));
+    }
+
+    // The calling thread takes part, so it counts as one of the threads
+    ThreadPool pool(options.threads == 0 ? ThreadPool::automatic : options.threads - 1);
+
+    std::ios::sync_with_stdio(false);
+    const auto start = std::chrono::steady_clock::now();
+    uint64_t files = 0;
+    uint64_t bytes = 0;
+    uint64_t errors = 0;
+    uint64_t skipped = 0;
+
+    // Files are hashed in batches so output keeps the walk order while
+    // memory stays bounded for any number of files
+    constexpr size_t batch_size = 4096;
+    std::vector<FileResult> batch;
+    batch.reserve(batch_size);
+    auto flush = [&] {
+        pool.parallel_for(batch.size(), [&](size_t i) { hash_file(options, pool, batch[i]); });
+        for (const auto& result : batch) {
+            print(options, result);
+            ++files;
+            bytes += result.size;
+            skipped += result.skipped;
+            errors += !result.error.empty() && !result.skipped;
+        }
+        batch.clear();
+    };
+    auto add = [&](std::string path, std::string error = {}) {
+        batch.push_back(FileResult{std::move(path), 0, Hash{{}}, std::move(error), false});
+        if (batch.size() == batch_size) {
+            flush();
+        }
+    };
+
+    namespace fs = std::filesystem;
+    for (const auto& path : options.paths) {
+        std::error_code error;
+        if (fs::is_directory(path, error)) {
+            fs::recursive_directory_iterator it(path, fs::directory_options::skip_permission_denied, error);
+            for (; !error && it != fs::recursive_directory_iterator(); it.increment(error)) {
+                if (it->is_regular_file(error)) {
+                    add(it->path().string());
+                }
+            }
+            if (error) {
+                add(path, "cannot walk directory: " + error.message());
+            }
+        } else {
+            add(path);
+        }
+    }
+    flush();
+    std::cout.flush();
+
+    if (options.summary) {
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::fprintf(stderr, "%llu files, %.1f MB, %llu skipped, %llu errors in %.3f s (%.1f MB/s, %zu threads)\n",
+                     static_cast<unsigned long long>(files), bytes / 1e6,
+                     static_cast<unsigned long long>(skipped), static_cast<unsigned long long>(errors),
+                     seconds, seconds > 0 ? bytes / 1e6 / seconds : 0.0, pool.concurrency());
+    }
+    return errors == 0 ? 0 : 1;
+}